@@ -19,7 +19,7 @@ Adafruit_SPIDevice::Adafruit_SPIDevice(int8_t cspin, uint32_t freq,
   _sck = _mosi = _miso = -1;
   _spi = theSPI;
   _begun = false;
-  _spiSetting = new SPISettings(freq, dataOrder, dataMode);
+  _spiSetting = SPISettings(freq, dataOrder, dataMode);
   _freq = freq;
   _dataOrder = dataOrder;
   _dataMode = dataMode;
@@ -76,14 +76,6 @@ Adafruit_SPIDevice::Adafruit_SPIDevice(int8_t cspin, int8_t sckpin,
   _begun = false;
 }
 
-/*!
- *    @brief  Release memory allocated in constructors
- */
-Adafruit_SPIDevice::~Adafruit_SPIDevice() {
-  if (_spiSetting)
-    delete _spiSetting;
-}
-
 /*!
  *    @brief  Initializes SPI bus and sets CS pin high
  *    @return Always returns true because there's no way to test success of SPI
@@ -283,7 +275,7 @@ uint8_t Adafruit_SPIDevice::transfer(uint8_t send) {
 void Adafruit_SPIDevice::beginTransaction(void) {
   if (_spi) {
 #ifdef BUSIO_HAS_HW_SPI
-    _spi->beginTransaction(*_spiSetting);
+    _spi->beginTransaction(_spiSetting);
 #endif
   }
 }
@@ -2,49 +2,77 @@
 #include <Adafruit_BusIO_Register.h>
 #include <Adafruit_SPIDevice.h>
 #include <SPI.h>
+#include <temperature_source.h>
+#include <sensor_filter.h>
+#include <telemetry.h>
+#include <eeprom_log.h>
 
-const int PT100_PIN = A13; // Analog input pin connected to the PT100 amplifier output
-const float VREF = 5.0;    // Voltage reference of the Arduino (3.3V or 5V, depending on the board)
+// Streams every PT100 reading as binary telemetry in centi-degrees C: the
+// median + low-pass filtered value on channel 0 and the raw reading on
+// channel 1. A filtered reading every 10 s is also kept in EEPROM; the
+// stored history is sent on startup (opening the port resets the board)
+// and when 'd' is received.
+// Decode on the host with telemetry/host/telemetry_decode.cpp:
+//   ./telemetry_decode /dev/ttyACM0 1000000
 
-// Add the provided temperature and VOut values to two arrays
-// taken from https://wiki.e3d-online.com/E3D_PT100_Amplifier_Documentation
-const int numDataPoints = 49;
-const int temperatures[numDataPoints] = {0, 1, 10, 20, 30, 40, 50, 60, 70, 80, 90, 100, 110, 120, 130, 140, 150, 160, 170, 180, 190, 200, 210, 220, 230, 240, 250, 260, 270, 280, 290, 300, 310, 320, 330, 340, 350, 360, 370, 380, 390, 400, 500, 600, 700, 800, 900, 1000, 1100};
-const float vOut[numDataPoints] = {0.00, 1.11, 1.15, 1.20, 1.24, 1.28, 1.32, 1.36, 1.40, 1.44, 1.48, 1.52, 1.56, 1.61, 1.65, 1.68, 1.72, 1.76, 1.80, 1.84, 1.88, 1.92, 1.96, 2.00, 2.04, 2.07, 2.11, 2.15, 2.18, 2.22, 2.26, 2.29, 2.33, 2.37, 2.41, 2.44, 2.48, 2.51, 2.55, 2.58, 2.62, 2.66, 3.00, 3.33, 3.63, 3.93, 4.21, 4.48, 4.73};
-
-void setup() {
-  Serial.begin(9600);
-  Serial.println("E3D PT100 Amplifier Sensor Test");
-}
+const int PT100_PIN = A13;         // Analog input pin connected to the PT100 amplifier output
+const uint16_t VREF_MV = 5000;     // Voltage reference of the Arduino (3300 or 5000, depending on the board)
+const uint16_t SAMPLE_PERIOD_MS = 2;
+const uint8_t TEMPERATURE_CHANNEL = 0;
+const uint8_t RAW_CHANNEL = 1;
 
-float interpolateTemperature(float voltage) {
-  // If the voltage is outside the valid range, return an error value
-  if (voltage < vOut[0] || voltage > vOut[numDataPoints - 1]) {
-    return -1000;
-  }
+// FILTER (5 sample median, then a 2.5 Hz Butterworth low-pass at 500 Hz)
+const uint8_t MEDIAN_WINDOW = 5;
+const float CUTOFF_RATIO = 0.005;
 
-  // Find the index of the voltage interval
-  int index = 0;
-  while (voltage > vOut[index + 1]) {
-    index++;
-  }
+// HISTORY LOG (EEPROM below LOG_EEPROM_START is left for settings)
+const uint16_t LOG_EEPROM_START = 256;
+const uint16_t LOG_EEPROM_SIZE = 3840;
+const uint16_t LOG_INTERVAL_MS = 10000;
+const uint32_t LOG_FLUSH_PERIOD_MS = 60000;
 
-  // Calculate the interpolated temperature using linear interpolation
-  float slope = (temperatures[index + 1] - temperatures[index]) / (vOut[index + 1] - vOut[index]);
-  float temperature = temperatures[index] + slope * (voltage - vOut[index]);
+// The amplifier calibration table lives in pt100.h
+// taken from https://wiki.e3d-online.com/E3D_PT100_Amplifier_Documentation
+Thermal::PT100Source rawPT100(PT100_PIN, SAMPLE_PERIOD_MS, VREF_MV);
+Thermal::FilteredSource<MEDIAN_WINDOW, Synth::BiquadLowPass32> pt100(rawPT100);
+Telemetry::Link<256> telemetry(Serial);
+Telemetry::EepromLog history(LOG_EEPROM_START, LOG_EEPROM_SIZE, LOG_INTERVAL_MS, TEMPERATURE_CHANNEL);
+unsigned long previousFlushMillis = 0;
 
-  return temperature;
+void setup() {
+  Serial.begin(Telemetry::DEFAULT_BAUD);
+  telemetry.sendText("E3D PT100 Amplifier Sensor Test");
+  telemetry.sendChannelInfo(TEMPERATURE_CHANNEL, -2, "pt100");
+  telemetry.sendChannelInfo(RAW_CHANNEL, -2, "pt100_raw");
+  pt100.pipeline().filter().setCutoff(CUTOFF_RATIO);
+  pt100.begin();
+  history.begin();
+  history.startDump();
 }
 
 void loop() {
-  int raw_adc = analogRead(PT100_PIN);
-  float voltage = (float)raw_adc * VREF / 1023.0;
+  unsigned long currentMillis = millis();
 
-  float temperature = interpolateTemperature(voltage);
+  if (pt100.poll(currentMillis)) {
+    const Thermal::TemperatureReading &reading = pt100.latest();
+    if (reading.valid) {
+      int32_t values[2] = { reading.centiC, rawPT100.latest().centiC };
+      telemetry.sendSamples(TEMPERATURE_CHANNEL, reading.timeMs, values, 2);
+    } else {
+      telemetry.sendText("Temperature out of range");
+    }
+    history.add(reading.timeMs, reading.centiC, reading.valid);
+  }
 
-  Serial.print("Raw ADC value: "); Serial.println(raw_adc);
-  Serial.print("Voltage: "); Serial.print(voltage, 3); Serial.println(" V");
-  Serial.print("Temperature: "); Serial.print(temperature, 2); Serial.println(" °C");
+  if (currentMillis - previousFlushMillis >= LOG_FLUSH_PERIOD_MS) {
+    previousFlushMillis = currentMillis;
+    history.flush();
+  }
 
-  delay(1000);
-}
\ No newline at end of file
+  if (Serial.available() && Serial.read() == 'd') {
+    history.startDump();
+  }
+  history.service();
+  history.serviceDump(telemetry);
+  telemetry.service();
+}
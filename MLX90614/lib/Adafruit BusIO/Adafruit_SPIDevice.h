@@ -96,7 +96,6 @@ public:
                      uint32_t freq = 1000000,
                      BusIOBitOrder dataOrder = SPI_BITORDER_MSBFIRST,
                      uint8_t dataMode = SPI_MODE0);
-  ~Adafruit_SPIDevice();
 
   bool begin(void);
   bool read(uint8_t *buffer, size_t len, uint8_t sendvalue = 0xFF);
@@ -117,10 +116,9 @@ public:
 private:
 #ifdef BUSIO_HAS_HW_SPI
   SPIClass *_spi = nullptr;
-  SPISettings *_spiSetting = nullptr;
+  SPISettings _spiSetting; ///< Stored in place, no heap allocation
 #else
   uint8_t *_spi = nullptr;
-  uint8_t *_spiSetting = nullptr;
 #endif
   uint32_t _freq;
   BusIOBitOrder _dataOrder;
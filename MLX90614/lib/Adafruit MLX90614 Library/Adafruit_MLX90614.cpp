@@ -18,10 +18,12 @@
 
 #include "Adafruit_MLX90614.h"
 
-Adafruit_MLX90614::~Adafruit_MLX90614() {
-  if (i2c_dev)
-    delete i2c_dev;
-}
+/**
+ * @brief Construct the driver with the bus interface held in place, so that
+ * neither construction nor repeated calls to begin() touch the heap
+ */
+Adafruit_MLX90614::Adafruit_MLX90614()
+    : i2c_dev(MLX90614_I2CADDR, &Wire), _addr(MLX90614_I2CADDR) {}
 
 /**
  * @brief Begin the I2C connection
@@ -31,10 +33,8 @@ Adafruit_MLX90614::~Adafruit_MLX90614() {
  */
 bool Adafruit_MLX90614::begin(uint8_t addr, TwoWire *wire) {
   _addr = addr; // needed for CRC
-  if (i2c_dev)
-    delete i2c_dev;
-  i2c_dev = new Adafruit_I2CDevice(addr, wire);
-  return i2c_dev->begin();
+  i2c_dev = Adafruit_I2CDevice(addr, wire);
+  return i2c_dev.begin();
 }
 
 /**
@@ -55,6 +55,7 @@ void Adafruit_MLX90614::writeEmissivityReg(uint16_t ereg) {
   delay(10);
   write16(MLX90614_EMISS, ereg);
   delay(10);
+  _sensorEmissivity = NAN; // re-read on next compensated reading
 }
 /**
  * @brief Read the emissivity value from the sensor's register and scale
@@ -79,6 +80,75 @@ void Adafruit_MLX90614::writeEmissivity(double emissivity) {
   writeEmissivityReg(ereg);
 }
 
+/**
+ * @brief Set the emissivity used by readObjectTempCompensatedC()
+ *
+ * Unlike writeEmissivity() this never touches the sensor's EEPROM, so it can
+ * be changed before every reading at no bus cost.
+ *
+ * @param emissivity The emissivity of the measured target, between 0.1 and 1.0
+ */
+void Adafruit_MLX90614::setTargetEmissivity(double emissivity) {
+  _targetEmissivity = emissivity;
+}
+
+/**
+ * @brief Get the object temperature corrected for the target emissivity set
+ * with setTargetEmissivity()
+ *
+ * @return double The temperature in degrees Celcius or NAN if reading failed
+ */
+double Adafruit_MLX90614::readObjectTempCompensatedC(void) {
+  return readObjectTempCompensatedC(_targetEmissivity);
+}
+
+/**
+ * @brief Get the object temperature corrected for a given target emissivity
+ *
+ * @param emissivity The emissivity of the measured target, between 0.1 and 1.0
+ * @return double The temperature in degrees Celcius or NAN if reading failed
+ */
+double Adafruit_MLX90614::readObjectTempCompensatedC(double emissivity) {
+  double sensorE = sensorEmissivity();
+  double objectC = readTemp(MLX90614_TOBJ1);
+  double ambientC = readTemp(MLX90614_TA);
+  return compensateEmissivity(objectC, ambientC, sensorE, emissivity);
+}
+
+/**
+ * @brief Re-scale an object temperature computed by the sensor with one
+ * emissivity to the temperature it would report with another
+ *
+ * The sensor linearises the IR signal as e * (To^4 - Ta^4), so the radiated
+ * term is rescaled by sensorEmissivity / targetEmissivity in Kelvin.
+ *
+ * @param objectC Object temperature reported by the sensor, in Celcius
+ * @param ambientC Ambient (die) temperature reported by the sensor, in Celcius
+ * @param sensorEmissivity Emissivity currently stored in the sensor's EEPROM
+ * @param targetEmissivity Emissivity of the measured target
+ * @return double The corrected temperature in degrees Celcius or NAN if any
+ * input is invalid
+ */
+double Adafruit_MLX90614::compensateEmissivity(double objectC, double ambientC,
+                                               double sensorEmissivity,
+                                               double targetEmissivity) {
+  if (isnan(objectC) || isnan(ambientC) || isnan(sensorEmissivity) ||
+      targetEmissivity <= 0)
+    return NAN;
+  if (sensorEmissivity == targetEmissivity)
+    return objectC;
+
+  // Work in hundreds of Kelvin to keep the fourth powers well scaled
+  double to = (objectC + 273.15) / 100.0;
+  double ta = (ambientC + 273.15) / 100.0;
+  double ta4 = ta * ta * ta * ta;
+  double to4 = ta4 + (to * to * to * to - ta4) * sensorEmissivity /
+                         targetEmissivity;
+  if (to4 <= 0)
+    return NAN;
+  return sqrt(sqrt(to4)) * 100.0 - 273.15;
+}
+
 /**
  * @brief Get the current temperature of an object in degrees Farenheit
  *
@@ -125,13 +195,19 @@ float Adafruit_MLX90614::readTemp(uint8_t reg) {
   return temp;
 }
 
+double Adafruit_MLX90614::sensorEmissivity(void) {
+  if (isnan(_sensorEmissivity))
+    _sensorEmissivity = readEmissivity();
+  return _sensorEmissivity;
+}
+
 /*********************************************************************/
 
 uint16_t Adafruit_MLX90614::read16(uint8_t a) {
   uint8_t buffer[3];
   buffer[0] = a;
   // read two bytes of data + pec
-  bool status = i2c_dev->write_then_read(buffer, 1, buffer, 3);
+  bool status = i2c_dev.write_then_read(buffer, 1, buffer, 3);
   if (!status)
     return 0;
   // return data, ignore pec
@@ -171,7 +247,7 @@ void Adafruit_MLX90614::write16(uint8_t a, uint16_t v) {
   buffer[2] = buffer[3];
   buffer[3] = pec;
 
-  i2c_dev->write(buffer, 4);
+  i2c_dev.write(buffer, 4);
 }
 
 
@@ -221,7 +297,7 @@ uint16_t Adafruit_MLX90614::readI2CAddr(void) {
   return read16(MLX90614_PWMCTRL);
 }
 
-String Adafruit_MLX90614::getCommunicationMode() {
+mlx90614_comm_mode_t Adafruit_MLX90614::getCommunicationMode() {
   uint16_t registerValue = read16(MLX90614_PWMCTRL);
 
   // Check bit 1
@@ -230,9 +306,9 @@ String Adafruit_MLX90614::getCommunicationMode() {
   bool bit1 = registerValue & (1 << 1);
 
   if (bit1) {
-    return "PWM";
+    return MLX90614_MODE_PWM;
   } else {
-    return "I2C";
+    return MLX90614_MODE_I2C;
   }
 }
 
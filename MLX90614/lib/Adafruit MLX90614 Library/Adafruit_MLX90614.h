@@ -15,6 +15,9 @@
   Written by Limor Fried/Ladyada for Adafruit in any redistribution
  ****************************************************/
 
+#ifndef ADAFRUIT_MLX90614_H
+#define ADAFRUIT_MLX90614_H
+
 #include <Adafruit_I2CDevice.h>
 #include <Arduino.h>
 
@@ -39,13 +42,21 @@
 #define MLX90614_ID3 0x3E
 #define MLX90614_ID4 0x3F
 
+/**
+ * @brief Output mode selected by bit 1 of the PWMCTRL register
+ */
+typedef enum {
+  MLX90614_MODE_I2C, ///< PWM disabled, readings over SMBus/I2C
+  MLX90614_MODE_PWM, ///< PWM output enabled
+} mlx90614_comm_mode_t;
+
 /**
  * @brief Class to read from and control a MLX90614 Temp Sensor
  *
  */
 class Adafruit_MLX90614 {
 public:
-  ~Adafruit_MLX90614();
+  Adafruit_MLX90614();
   bool begin(uint8_t addr = MLX90614_I2CADDR, TwoWire *wire = &Wire);
 
   // TEMPERATURE
@@ -60,6 +71,14 @@ public:
   double readEmissivity(void);
   void writeEmissivity(double emissivity);
 
+  // SOFTWARE EMISSIVITY COMPENSATION
+  void setTargetEmissivity(double emissivity);
+  double readObjectTempCompensatedC(void);
+  double readObjectTempCompensatedC(double emissivity);
+  static double compensateEmissivity(double objectC, double ambientC,
+                                     double sensorEmissivity,
+                                     double targetEmissivity);
+
   // MIN TEMP
   int readTempMin(void);
   void writeTempMin(int minTemp);
@@ -69,7 +88,7 @@ public:
   void writeTempMax(int maxTemp);
 
   // COMMUNICATION PROTOCOL
-  String getCommunicationMode(void);
+  mlx90614_comm_mode_t getCommunicationMode(void);
   uint16_t readI2CAddr(void);
   void switchToPWM(void);
   void switchToI2C(void);
@@ -78,11 +97,16 @@ public:
   void printAllRegisters(void);
 
 private:
-  Adafruit_I2CDevice *i2c_dev = NULL; ///< Pointer to I2C bus interface
+  Adafruit_I2CDevice i2c_dev; ///< I2C bus interface, stored in place
   float readTemp(uint8_t reg);
+  double sensorEmissivity(void);
 
   uint16_t read16(uint8_t addr);
   void write16(uint8_t addr, uint16_t data);
   byte crc8(byte *addr, byte len);
   uint8_t _addr;
+  double _sensorEmissivity = NAN; ///< Cached EMISS register, NAN until read
+  double _targetEmissivity = 1.0; ///< Emissivity applied in software
 };
+
+#endif // ADAFRUIT_MLX90614_H
@@ -0,0 +1,179 @@
+#include <Arduino.h>
+#include <Adafruit_MLX90614.h>
+#include <Adafruit_BusIO_Register.h>
+#include <Adafruit_SPIDevice.h>
+#include <SPI.h>
+#include <autotune.h>
+#include <heater_output.h>
+#include <pid.h>
+#include <temperature_source.h>
+
+// *** AUTOTUNE HEATER AND SAVE PID GAINS TO EEPROM ***
+// Start with the zone cold and settled. Send 'r' for a relay test around
+// TARGET_TEMP or 's' for an open-loop step test at STEP_DUTY. When the test
+// finishes the model and gains are stored in EEPROM and the zone switches
+// to PID control at TARGET_TEMP with the new gains.
+
+// TEMPERATURE SOURCE (pick one)
+#define SOURCE_MLX_PWM 0
+#define SOURCE_MLX_I2C 1
+#define SOURCE_PT100   2
+#define TEMP_SOURCE SOURCE_MLX_PWM
+
+#if TEMP_SOURCE == SOURCE_MLX_I2C
+#include <mlx_i2c_source.h>
+#endif
+
+// PIN DEFINITIONS
+// The sensor PWM is timed by edge interrupts, so IR_SENSOR_PIN must be an
+// external interrupt pin (Mega: 2, 3, 18, 19, 20, 21).
+const int IR_SENSOR_PIN = 18;
+const int PT100_PIN = A13;
+const int HEAT_PIN = 36;
+const int16_t T0_MIN = -10;   // Sensor PWM output range in Celsius
+const int16_t T0_MAX = 160;
+
+// TARGET TEMPERATURE
+const float TARGET_TEMP = 40.0;
+
+// AUTOTUNE SETTINGS
+const uint16_t CONTROL_PERIOD_MS = 250;
+const uint16_t STEP_DUTY = 32768;      // 50% for the step test
+const int TUNING_EEPROM_ADDR = 0;
+
+#if TEMP_SOURCE == SOURCE_MLX_PWM
+Thermal::MLXPWMSource sensor(IR_SENSOR_PIN, T0_MIN, T0_MAX);
+#elif TEMP_SOURCE == SOURCE_MLX_I2C
+Adafruit_MLX90614 mlx = Adafruit_MLX90614();
+Thermal::MLXI2CSource sensor(mlx);
+#else
+Thermal::PT100Source sensor(PT100_PIN);
+#endif
+Thermal::PID pid(CONTROL_PERIOD_MS);
+Thermal::RelayAutotuner relayTuner;
+Thermal::StepAutotuner stepTuner;
+Thermal::HeaterOutputISR& heater = Thermal::HeaterOutputISR::instance();
+uint8_t heaterChannel;
+
+enum Mode { MODE_PID, MODE_RELAY, MODE_STEP };
+Mode mode = MODE_PID;
+bool tuned = false;
+unsigned long previousMillis = 0;
+
+ISR(TIMER_HEATER_COMPA_vect) {
+  heater.handleInterrupt();
+}
+
+void printTuning(const Thermal::Tuning &tuning) {
+  Serial.print("K = "); Serial.print(tuning.model.gain); Serial.println(" C/duty");
+  Serial.print("tau = "); Serial.print(tuning.model.timeConstant); Serial.println(" s");
+  Serial.print("theta = "); Serial.print(tuning.model.deadTime); Serial.println(" s");
+  Serial.print("Kp = "); Serial.print(tuning.kp, 4);
+  Serial.print("\tKi = "); Serial.print(tuning.ki, 5);
+  Serial.print("\tKd = "); Serial.println(tuning.kd, 4);
+}
+
+void applyTuning(const Thermal::Tuning &tuning) {
+  pid.setTunings(tuning.kp, tuning.ki, tuning.kd);
+  tuned = true;
+}
+
+void setup() {
+  Serial.begin(9600);
+
+#if TEMP_SOURCE == SOURCE_MLX_I2C
+  if (!mlx.begin()) {
+    Serial.println("Error connecting to MLX sensor. Check wiring.");
+    while (1);
+  };
+#endif
+  sensor.begin();
+
+  heater.begin();
+  heaterChannel = heater.attach(HEAT_PIN);
+  pid.setSetpoint((int32_t)(TARGET_TEMP * 100));
+
+  Thermal::Tuning tuning;
+  if (Thermal::loadTuning(TUNING_EEPROM_ADDR, tuning)) {
+    Serial.println("Loaded tuning from EEPROM:");
+    printTuning(tuning);
+    applyTuning(tuning);
+  } else {
+    Serial.println("No tuning in EEPROM, heater off until autotuned");
+  }
+  Serial.println("Send 'r' for relay autotune, 's' for step autotune");
+}
+
+void finishAutotune(Thermal::AutotuneState state, const Thermal::Tuning &tuning,
+                    int32_t temperature) {
+  heater.setDuty(heaterChannel, 0);
+  mode = MODE_PID;
+
+  if (state != Thermal::AutotuneState::DONE) {
+    Serial.println("Autotune failed, keeping previous gains");
+    return;
+  }
+
+  Serial.println("Autotune done:");
+  printTuning(tuning);
+  Thermal::saveTuning(TUNING_EEPROM_ADDR, tuning);
+  applyTuning(tuning);
+  pid.reset(temperature, 0);
+}
+
+void loop() {
+  if (Serial.available()) {
+    char c = Serial.read();
+    if (c == 'r') {
+      Serial.println("Relay autotune started");
+      relayTuner.begin((int32_t)(TARGET_TEMP * 100));
+      mode = MODE_RELAY;
+    } else if (c == 's') {
+      Serial.println("Step autotune started");
+      stepTuner.begin(STEP_DUTY);
+      mode = MODE_STEP;
+    }
+  }
+
+  // Polled every pass, never waits on the sensor
+  unsigned long currentMillis = millis();
+  sensor.poll(currentMillis);
+  if (currentMillis - previousMillis < CONTROL_PERIOD_MS) {
+    return;
+  }
+  previousMillis = currentMillis;
+
+  if (!sensor.isFresh(currentMillis, CONTROL_PERIOD_MS)) {
+    Serial.println("No temperature reading, heater off");
+    heater.setDuty(heaterChannel, 0);
+    return;
+  }
+  int32_t temperature = sensor.latest().centiC;
+
+  uint16_t duty = 0;
+  switch (mode) {
+    case MODE_RELAY:
+      duty = relayTuner.update(temperature, currentMillis);
+      if (relayTuner.isDone()) {
+        finishAutotune(relayTuner.getState(), relayTuner.getResult(), temperature);
+        return;
+      }
+      break;
+
+    case MODE_STEP:
+      duty = stepTuner.update(temperature, currentMillis);
+      if (stepTuner.isDone()) {
+        finishAutotune(stepTuner.getState(), stepTuner.getResult(), temperature);
+        return;
+      }
+      break;
+
+    case MODE_PID:
+      duty = tuned ? pid.update(temperature) : 0;
+      break;
+  }
+  heater.setDuty(heaterChannel, duty);
+
+  Serial.print("Temperature: "); Serial.print(temperature / 100.0);
+  Serial.print(" C\tDuty: "); Serial.print((duty * 100UL) >> 16); Serial.println(" %");
+}
@@ -0,0 +1,69 @@
+#include <Arduino.h>
+#include <Adafruit_MLX90614.h>
+#include <Adafruit_BusIO_Register.h>
+#include <Adafruit_SPIDevice.h>
+#include <SPI.h>
+#include <mlx_i2c_source.h>
+#include <sensor_fusion.h>
+#include <telemetry.h>
+
+// *** FUSED IR + PT100 TEMPERATURE ***
+// The MLX90614 and a PT100 measure the same part. A Kalman filter follows
+// the fast IR reading during ramps and uses the PT100 to learn the IR bias
+// once the part settles, giving a corrected estimate at the IR rate.
+// Streams raw IR (channel 0), raw PT100 (1), the fused estimate (2) and the
+// learned IR bias (3) in centi-degrees C as binary telemetry.
+// Decode on the host with telemetry/host/telemetry_decode.cpp:
+//   ./telemetry_decode /dev/ttyACM0 1000000
+const uint16_t IR_PERIOD_MS = 20;
+const uint16_t PT100_PERIOD_MS = 100;
+
+// NOISE MODEL (centi-degrees C)
+const uint16_t IR_NOISE = 20;
+const uint16_t PT100_NOISE = 10;
+const uint16_t PT100_LAG_MS = 4000;      // Probe time constant in the block
+const uint16_t TEMPERATURE_WANDER = 30;  // per sqrt(second)
+const uint16_t BIAS_WANDER = 1;          // per sqrt(second)
+
+Adafruit_MLX90614 mlx = Adafruit_MLX90614();
+Thermal::MLXI2CSource objectIR(mlx, IR_PERIOD_MS);
+Thermal::PT100Source blockPT100(A13, PT100_PERIOD_MS);
+Thermal::FusedTemperatureSource fused(objectIR, blockPT100);
+Telemetry::Link<256> telemetry(Serial);
+
+void setup() {
+  Serial.begin(Telemetry::DEFAULT_BAUD);
+  while (!Serial);
+
+  if (!mlx.begin()) {
+    telemetry.sendText("Error connecting to MLX sensor. Check wiring.");
+  };
+
+  Thermal::TemperatureKalman &filter = fused.filter();
+  filter.setIRNoise(IR_NOISE);
+  filter.setContactNoise(PT100_NOISE, PT100_LAG_MS);
+  filter.setProcessNoise(TEMPERATURE_WANDER, BIAS_WANDER);
+  fused.begin();
+
+  telemetry.sendChannelInfo(0, -2, "ir");
+  telemetry.sendChannelInfo(1, -2, "pt100");
+  telemetry.sendChannelInfo(2, -2, "fused");
+  telemetry.sendChannelInfo(3, -2, "ir_bias");
+}
+
+void loop() {
+  telemetry.service();
+
+  unsigned long currentMillis = millis();
+  if (!fused.poll(currentMillis)) {
+    return;
+  }
+
+  int32_t values[4] = {
+    objectIR.latest().centiC,
+    blockPT100.latest().centiC,
+    fused.latest().valid ? fused.latest().centiC : 0,
+    fused.filter().getBias()
+  };
+  telemetry.sendSamples(0, currentMillis, values, 4);
+}
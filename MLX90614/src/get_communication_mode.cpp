@@ -18,7 +18,11 @@ void setup() {
 
   mlx.begin();
 
-  Serial.println(mlx.getCommunicationMode());
+  if (mlx.getCommunicationMode() == MLX90614_MODE_PWM) {
+    Serial.println("PWM");
+  } else {
+    Serial.println("I2C");
+  }
 }
 
 void loop() {
@@ -3,76 +3,115 @@
 #include <Adafruit_BusIO_Register.h>
 #include <Adafruit_SPIDevice.h>
 #include <SPI.h>
+#include <pid.h>
+#include <heater_output.h>
+#include <predictive_cutoff.h>
+#include <autotune.h>
+#include <scheduler.h>
+#include <mlx_capture_source.h>
 
 // PIN DEFINITIONS
-const int IR_SENSOR_PIN = 4;
+// The sensor PWM is timed by the TIMER_CAPTURE input capture instead of
+// pulseIn(), so the control task never waits on it: wire it to
+// Thermal::MLXCaptureSource::PIN (pin 48 on the Mega).
 const int HEAT_PIN = 36;
 
 // TARGET TEMPERATURE
 const float TARGET_TEMP = 40.0;
 
+// CONTROL LOOP
+// The heater pin is switched by TIMER_HEATER in a 1 s time-proportioning
+// window, the PID runs as a scheduler task every CONTROL_PERIOD_MS.
+const uint16_t CONTROL_PERIOD_MS = 250;
+const int16_t T0_MIN = -10;   // Sensor PWM output range in Celsius
+const int16_t T0_MAX = 160;
+const float KP = 0.10; // 10% duty per degree C of error
+const float KI = 0.002;
+const float KD = 0.50;
+
+// APPROACH
+// From cold the heater runs at full power until the predicted peak
+// (temperature + heating rate * dead time) reaches the target, then the PID
+// takes over. The dead time comes from the autotuned model if one is stored.
+const uint32_t DEFAULT_DEAD_TIME_MS = 10000;
+const int TUNING_EEPROM_ADDR = 0;
+
 // GLOBAL VARIABLES
-unsigned long previousMillis = 0;
-float previousTemperature = 0;
-float heatingRate = 0;
+bool approaching = true;
 
-bool shouldStopHeating(float currentTemperature, float targetTemperature, float heatingRate) {
-  float timeToReachTarget = (targetTemperature - currentTemperature) / heatingRate;
-  float predictedTemperature = currentTemperature + (heatingRate * timeToReachTarget);
+Thermal::PID pid(CONTROL_PERIOD_MS);
+Thermal::PredictiveCutoff<16> cutoff(DEFAULT_DEAD_TIME_MS);
+Thermal::MLXCaptureSource irSensor(T0_MIN, T0_MAX);
+Thermal::HeaterOutputISR& heater = Thermal::HeaterOutputISR::instance();
+uint8_t heaterChannel;
+Tasks::Scheduler<1> scheduler;
 
-  return predictedTemperature >= targetTemperature;
+ISR(TIMER_HEATER_COMPA_vect) {
+  heater.handleInterrupt();
 }
 
-void setup() {
-  pinMode(IR_SENSOR_PIN, INPUT);
-  pinMode(HEAT_PIN, OUTPUT);
-  Serial.begin(9600);
+ISR(TIMER_CAPTURE_CAPT_vect) {
+  irSensor.handleCapture();
 }
 
-void loop() {
-  // Get the current time in milliseconds
+void updateControl() {
   unsigned long currentMillis = millis();
-  // Measure the duration of the HIGH state of the PWM signal
-  unsigned long highDuration = pulseIn(IR_SENSOR_PIN, HIGH);
-  
-  // Constants for the temperature range
-  float T0_MIN = -10.0; // Minimum temperature in Celsius
-  float T0_MAX = 160.0; // Maximum temperature in Celsius
-  float T2 = 2048.0;    // Total number of clock cycles in a PWM period
-
-  // Calculate the temperature in Celsius
-  float temperatureInCelsius = (2 * (highDuration / T2) * (T0_MAX - T0_MIN)) + T0_MIN;
-  
-  // Print the temperature
-  Serial.print("Temperature: "); Serial.print(temperatureInCelsius); Serial.println(" C");
-
-  // Calculate the heating rate
-  if (previousMillis != 0) {
-    float deltaTime = (currentMillis - previousMillis) / 1000.0; // convert to seconds
-    heatingRate = (temperatureInCelsius - previousTemperature) / deltaTime;
+
+  // Latest pulse measured by the capture interrupt
+  irSensor.poll(currentMillis);
+  if (!irSensor.isFresh(currentMillis, CONTROL_PERIOD_MS)) {
+    Serial.println("No PWM signal from sensor, heater off");
+    heater.setDuty(heaterChannel, 0);
+    return;
   }
 
-  if (temperatureInCelsius < TARGET_TEMP) {
-      Serial.println("Heating...");
-      digitalWrite(HEAT_PIN, HIGH);
-  
-  } else if (temperatureInCelsius > TARGET_TEMP) {
-      Serial.println("Cooling...");
-      digitalWrite(HEAT_PIN, LOW);
-  
+  int32_t temperature = irSensor.latest().centiC;
+  int32_t target = (int32_t)(TARGET_TEMP * 100);
+
+  // Track the heating rate over the last 16 readings (4 s)
+  cutoff.add(currentMillis, temperature);
+
+  uint16_t duty;
+  if (approaching && cutoff.shouldStopHeating(target)) {
+    Serial.println("Stopping heating, handing over to PID...");
+    approaching = false;
+    pid.reset(temperature, 0);
+  }
+
+  if (approaching) {
+    duty = Thermal::PID::OUTPUT_MAX;
   } else {
-      Serial.println("Temperature is at target.");
-      digitalWrite(HEAT_PIN, LOW);
+    // Update the controller and hand the duty to the timer-driven output
+    duty = pid.update(temperature);
   }
+  heater.setDuty(heaterChannel, duty);
+
+  // Print the temperature, heating rate and heater duty
+  Serial.print("Temperature: "); Serial.print(temperature / 100.0);
+  Serial.print(" C\tRate: "); Serial.print(cutoff.rate(60000UL) / 100.0);
+  Serial.print(" C/min\tDuty: "); Serial.print((duty * 100UL) >> 16); Serial.println(" %");
+}
 
-//   // Turn the heating element on or off
-//   if (shouldStopHeating(temperatureInCelsius, TARGET_TEMP, heatingRate)) {
-//     Serial.println("Stopping heating...");
-//     digitalWrite(HEAT_PIN, LOW);
-//   } else {
-//     Serial.println("Heating...");
-//     digitalWrite(HEAT_PIN, HIGH);
-//   }
-  
-  delay(1000);
-}
\ No newline at end of file
+void setup() {
+  Serial.begin(9600);
+  irSensor.begin();
+
+  Thermal::Tuning tuning;
+  if (Thermal::loadTuning(TUNING_EEPROM_ADDR, tuning)) {
+    pid.setTunings(tuning.kp, tuning.ki, tuning.kd);
+    cutoff.setDeadTime((uint32_t)(tuning.model.deadTime * 1000));
+  } else {
+    pid.setTunings(KP, KI, KD);
+  }
+  pid.setSetpoint((int32_t)(TARGET_TEMP * 100));
+
+  heater.begin();
+  heaterChannel = heater.attach(HEAT_PIN);
+
+  scheduler.addPeriodic("control", updateControl, CONTROL_PERIOD_MS * 1000UL);
+  scheduler.begin();
+}
+
+void loop() {
+  scheduler.run();
+}
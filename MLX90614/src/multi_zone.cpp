@@ -0,0 +1,118 @@
+#include <Arduino.h>
+#include <Adafruit_MLX90614.h>
+#include <Adafruit_BusIO_Register.h>
+#include <Adafruit_SPIDevice.h>
+#include <SPI.h>
+#include <mlx_i2c_source.h>
+#include <zone_controller.h>
+#include <scheduler.h>
+
+// *** MULTI-ZONE HEATER CONTROL ***
+// One PID per zone, each zone reading its own sensor and driving its own
+// heater pin. Sensors are polled without blocking and zones are serviced
+// one per time slot so the loop stays responsive as zones are added.
+// Zone servicing and reporting run as scheduler tasks; the report includes
+// the CPU load and the worst run time of each task. The report prints one
+// short line per run, and only when the serial TX buffer has room for it,
+// so Serial.print never blocks the 2 ms zones task at 9600 baud.
+
+// ZONE TABLE
+const uint16_t CONTROL_PERIOD_MS = 500;
+const uint8_t MAX_ZONES = 4;
+const uint32_t ZONE_TASK_PERIOD_US = 2000;
+const uint32_t REPORT_LINE_PERIOD_US = 200000UL;
+const uint8_t REPORT_LINE_MAX = 48;      // Longest report line, must fit the TX buffer
+
+Adafruit_MLX90614 mlx = Adafruit_MLX90614();
+Thermal::MLXI2CSource hotendIR(mlx);
+Thermal::MLXPWMSource platenIR(18);     // Must be an external interrupt pin
+Thermal::PT100Source blockPT100(A13);
+Thermal::ZoneController<MAX_ZONES> zones(CONTROL_PERIOD_MS);
+Thermal::HeaterOutputISR& heater = Thermal::HeaterOutputISR::instance();
+Tasks::Scheduler<2> scheduler;
+
+struct ZoneSetup {
+  const char *name;
+  Thermal::TemperatureSource *source;
+  uint8_t heaterPin;
+  float target;
+};
+
+const ZoneSetup ZONE_SETUP[] = {
+  {"Hotend IR",   &hotendIR,   36, 40.0},
+  {"Platen IR",   &platenIR,   38, 60.0},
+  {"Block PT100", &blockPT100, 40, 200.0},
+};
+const uint8_t numZones = sizeof(ZONE_SETUP) / sizeof(ZONE_SETUP[0]);
+
+ISR(TIMER_HEATER_COMPA_vect) {
+  heater.handleInterrupt();
+}
+
+void serviceZones() {
+  zones.service(millis());
+}
+
+// Report one line per run: each zone, the CPU load, then each task's
+// statistics since the last report cycle
+uint8_t reportLine = 0;
+
+void reportZones() {
+  if (Serial.availableForWrite() < REPORT_LINE_MAX) return;
+
+  uint8_t zoneCount = zones.getCount();
+  if (reportLine < zoneCount) {
+    const Thermal::Zone &z = zones.zone(reportLine);
+    Serial.print(z.name); Serial.print(": ");
+    if (z.valid) {
+      Serial.print(z.temperature / 100.0); Serial.print(" C");
+    } else {
+      Serial.print("sensor fault");
+    }
+    Serial.print("\tDuty: "); Serial.print((z.duty * 100UL) >> 16); Serial.println(" %");
+  } else if (reportLine == zoneCount) {
+    Serial.print("Load: "); Serial.print(scheduler.getLoad() / 10.0); Serial.println(" %");
+  } else {
+    const Tasks::Task &task = scheduler.task(reportLine - zoneCount - 1);
+    Serial.print(task.name);
+    Serial.print(" max "); Serial.print(task.stats.maxUs); Serial.print(" us");
+    Serial.print(" late "); Serial.println(task.stats.late);
+  }
+
+  reportLine++;
+  if (reportLine > zoneCount + scheduler.getCount()) {
+    reportLine = 0;
+    scheduler.resetStats();
+  }
+}
+
+void setup() {
+  Serial.begin(9600);
+
+  if (!mlx.begin()) {
+    Serial.println("Error connecting to MLX sensor. Check wiring.");
+    while (1);
+  };
+
+  heater.begin();
+
+  for (uint8_t i = 0; i < numZones; i++) {
+    int8_t index = zones.addZone(ZONE_SETUP[i].source, ZONE_SETUP[i].heaterPin, ZONE_SETUP[i].name);
+    if (index < 0) {
+      Serial.print("Could not add zone "); Serial.println(ZONE_SETUP[i].name);
+      continue;
+    }
+    zones.zone(index).pid.setTunings(0.10, 0.002, 0.50);
+    zones.setSetpoint(index, (int32_t)(ZONE_SETUP[i].target * 100));
+  }
+
+  zones.begin();
+
+  scheduler.addPeriodic("zones", serviceZones, ZONE_TASK_PERIOD_US);
+  scheduler.addPeriodic("report", reportZones, REPORT_LINE_PERIOD_US);
+  scheduler.begin();
+}
+
+void loop() {
+  scheduler.run();
+}
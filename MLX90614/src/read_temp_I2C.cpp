@@ -3,33 +3,122 @@
 #include <Adafruit_BusIO_Register.h>
 #include <Adafruit_SPIDevice.h>
 #include <SPI.h>
+#include <telemetry.h>
+#include <rolling_stats.h>
+#include <sensor_filter.h>
 
 // *** READ TEMP IN I2C MODE ***
+// Streams ambient (channel 0) and object (channel 1) temperatures in
+// centi-degrees C as binary telemetry. Once a second the min, max, mean and
+// standard deviation of the object temperature over the last STATS_WINDOW
+// samples follow on channels 2-5, and alarms are reported as text.
+// The object temperature goes through a median + one-pole filter first so
+// SMBus glitches do not skew the statistics or raise alarms; the filtered
+// value is channel 6.
+// Decode on the host with telemetry/host/telemetry_decode.cpp:
+//   ./telemetry_decode /dev/ttyACM0 1000000
+const uint16_t SAMPLE_PERIOD_MS = 10;
+const uint16_t STATS_PERIOD_MS = 1000;
+const uint8_t STATS_WINDOW = 64;
+const uint8_t MEDIAN_WINDOW = 3;
+const uint8_t SMOOTHING = 192;          // One-pole coefficient, 0-255
+
+// ALARMS (centi-degrees C)
+const int32_t ALARM_LOW = 500;
+const int32_t ALARM_HIGH = 8000;
+const int32_t ALARM_HYSTERESIS = 50;
+const int32_t ALARM_RATE = 200;          // per second
+
 Adafruit_MLX90614 mlx = Adafruit_MLX90614();
+Telemetry::Link<256> telemetry(Serial);
+Thermal::ChannelMonitor<STATS_WINDOW, int32_t> objectMonitor;
+Thermal::SensorFilter<MEDIAN_WINDOW> objectFilter;
+unsigned long previousMillis = 0;
+unsigned long previousStatsMillis = 0;
+
+// Send a float register reading as text, e.g. "Emissivity = 0.95"
+void sendSetting(const char *name, double value) {
+  char text[40];
+  char number[12];
+  dtostrf(value, 1, 2, number);
+  snprintf(text, sizeof(text), "%s = %s", name, number);
+  telemetry.sendText(text);
+}
 
 void setup() {
-  Serial.begin(9600);
+  Serial.begin(Telemetry::DEFAULT_BAUD);
   while (!Serial);
 
-  // if (!mlx.begin()) {
-  //   Serial.println("Error connecting to MLX sensor. Check wiring.");
-  //   while (1);
-  // };
+  if (!mlx.begin()) {
+    telemetry.sendText("Error connecting to MLX sensor. Check wiring.");
+    while (1) telemetry.service();
+  };
+
+  sendSetting("Emissivity", mlx.readEmissivity());
+  sendSetting("Temp Max", mlx.readTempMax());
+  sendSetting("Temp Min", mlx.readTempMin());
 
-  Serial.print("Emissivity = "); Serial.println(mlx.readEmissivity());
-  Serial.println("================================================");
+  telemetry.sendChannelInfo(0, -2, "ambient");
+  telemetry.sendChannelInfo(1, -2, "object");
+  telemetry.sendChannelInfo(2, -2, "object_min");
+  telemetry.sendChannelInfo(3, -2, "object_max");
+  telemetry.sendChannelInfo(4, -2, "object_mean");
+  telemetry.sendChannelInfo(5, -2, "object_stddev");
+  telemetry.sendChannelInfo(6, -2, "object_filtered");
 
-  Serial.print("Temp Max= "); Serial.println(mlx.readTempMax());
-  Serial.println("================================================");
+  objectMonitor.setThresholds(ALARM_LOW, ALARM_HIGH, ALARM_HYSTERESIS);
+  objectMonitor.setRateLimit(ALARM_RATE);
+  objectFilter.filter().setCoefficient(SMOOTHING);
+}
 
-  Serial.print("Temp Min = "); Serial.println(mlx.readTempMin());
-  Serial.println("================================================");
+void sendAlarms(uint8_t alarms) {
+  char text[48];
+  snprintf(text, sizeof(text), "Object alarms:%s%s%s%s%s",
+           alarms == Thermal::ALARM_NONE ? " none" : "",
+           alarms & Thermal::ALARM_HIGH ? " high" : "",
+           alarms & Thermal::ALARM_LOW ? " low" : "",
+           alarms & Thermal::ALARM_RISE ? " rising" : "",
+           alarms & Thermal::ALARM_FALL ? " falling" : "");
+  telemetry.sendText(text);
 }
 
 void loop() {
-  Serial.print("Ambient = "); Serial.print(mlx.readAmbientTempC());
-  Serial.print("*C\tObject = "); Serial.print(mlx.readObjectTempC()); Serial.println("*C");
+  telemetry.service();
 
-  Serial.println();
-  delay(1000);
-}
\ No newline at end of file
+  unsigned long currentMillis = millis();
+  if (currentMillis - previousMillis < SAMPLE_PERIOD_MS) {
+    return;
+  }
+  previousMillis = currentMillis;
+
+  // Reads return NAN on a bus error: skip the sample rather than feed
+  // garbage to the filter and statistics
+  float ambient = mlx.readAmbientTempC();
+  float object = mlx.readObjectTempC();
+  if (isnan(ambient) || isnan(object)) {
+    return;
+  }
+
+  int32_t temperatures[2] = {
+    (int32_t)(ambient * 100),
+    (int32_t)(object * 100)
+  };
+  telemetry.sendSamples(0, currentMillis, temperatures, 2);
+
+  int32_t filtered = objectFilter.process(temperatures[1]);
+  telemetry.sendSample(6, currentMillis, filtered);
+
+  objectMonitor.add(currentMillis, filtered);
+  if (objectMonitor.alarmsChanged()) {
+    sendAlarms(objectMonitor.getAlarms());
+  }
+
+  if (currentMillis - previousStatsMillis >= STATS_PERIOD_MS) {
+    previousStatsMillis = currentMillis;
+    const Thermal::RollingStats<STATS_WINDOW, int32_t> &stats = objectMonitor.getStats();
+    int32_t summary[4] = {
+      stats.getMin(), stats.getMax(), stats.getMean(), (int32_t)stats.getStddev()
+    };
+    telemetry.sendSamples(2, currentMillis, summary, 4);
+  }
+}
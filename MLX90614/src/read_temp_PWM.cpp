@@ -3,31 +3,42 @@
 #include <Adafruit_BusIO_Register.h>
 #include <Adafruit_SPIDevice.h>
 #include <SPI.h>
+#include <temperature_source.h>
 
 // *** READ TEMPERATURE FROM PWM MODE ***
-const int PWM_PIN = 6;
+// The PWM output is timed by pin change interrupts, so PWM_PIN must be an
+// external interrupt pin (Mega: 2, 3, 18, 19, 20, 21).
+const int PWM_PIN = 2;
+
+// Output range set with set_temp_limits (TOMIN / TOMAX)
+const int16_t T0_MIN = -10;  // Minimum temperature in Celsius
+const int16_t T0_MAX = 125;  // Maximum temperature in Celsius
+
+const uint16_t PRINT_PERIOD_MS = 1000;
+
+Thermal::MLXPWMSource irSensor(PWM_PIN, T0_MIN, T0_MAX);
+unsigned long previousMillis = 0;
 
 void setup() {
-  pinMode(PWM_PIN, INPUT);
   Serial.begin(9600);
+  irSensor.begin();
 }
 
 void loop() {
-  // Measure the duration of the HIGH state of the PWM signal
-  unsigned long highDuration = pulseIn(PWM_PIN, HIGH);
-
-  // Serial.println(highDuration);
-  // Constants for the temperature range
-  double T0_MIN = -10; // Minimum temperature in Celsius
-  double T0_MAX = 125.0; // Maximum temperature in Celsius
-  double T2 = 2048.0;    // Total number of clock cycles in a PWM period
-
-  // Calculate the temperature in Celsius
-  // double temperatureInCelsius = (2 * (highDuration / T2) * (T0_MAX - T0_MIN)) / 40 + T0_MIN;
-  
+  unsigned long currentMillis = millis();
+  irSensor.poll(currentMillis);
+
+  if (currentMillis - previousMillis < PRINT_PERIOD_MS) {
+    return;
+  }
+  previousMillis = currentMillis;
+
+  const Thermal::TemperatureReading &reading = irSensor.latest();
+  if (!reading.valid) {
+    Serial.println("No PWM signal. Check wiring and communication mode.");
+    return;
+  }
   Serial.print("Temperature: ");
-  Serial.print(temperatureInCelsius);
+  Serial.print(reading.centiC / 100.0);
   Serial.println(" C");
-  
-  delay(1000);
-}
\ No newline at end of file
+}
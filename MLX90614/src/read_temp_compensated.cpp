@@ -0,0 +1,59 @@
+#include <Arduino.h>
+#include <Adafruit_MLX90614.h>
+#include <Adafruit_BusIO_Register.h>
+#include <Adafruit_SPIDevice.h>
+#include <SPI.h>
+#include <scheduler.h>
+
+// *** READ TEMP WITH PER-TARGET EMISSIVITY (NO EEPROM WRITES) ***
+// Readings are printed by a scheduler task once a second instead of a
+// delay(), so loop() stays free for other tasks.
+const uint32_t PRINT_PERIOD_US = 1000000UL;
+
+Adafruit_MLX90614 mlx = Adafruit_MLX90614();
+Tasks::Scheduler<1> scheduler;
+
+// Targets measured by the same sensor, each with its own emissivity.
+// The sensor's EEPROM emissivity is left untouched; readings are
+// corrected in software instead.
+struct Target {
+  const char *name;
+  double emissivity;
+};
+
+const Target TARGETS[] = {
+  {"Oxidized 304 SS", 0.30},
+  {"Anodized Al", 0.77},
+  {"PLA", 0.92},
+};
+const int numTargets = sizeof(TARGETS) / sizeof(TARGETS[0]);
+
+void printTargets() {
+  for (int i = 0; i < numTargets; i++) {
+    mlx.setTargetEmissivity(TARGETS[i].emissivity);
+    Serial.print(TARGETS[i].name);
+    Serial.print(" = "); Serial.print(mlx.readObjectTempCompensatedC()); Serial.println("*C");
+  }
+
+  Serial.println();
+}
+
+void setup() {
+  Serial.begin(9600);
+  while (!Serial);
+
+  if (!mlx.begin()) {
+    Serial.println("Error connecting to MLX sensor. Check wiring.");
+    while (1);
+  };
+
+  Serial.print("Sensor emissivity = "); Serial.println(mlx.readEmissivity());
+  Serial.println("================================================");
+
+  scheduler.addPeriodic("print", printTargets, PRINT_PERIOD_US);
+  scheduler.begin();
+}
+
+void loop() {
+  scheduler.run();
+}
@@ -16,8 +16,6 @@ void setup() {
     while (1);
   };
 
-  mlx.begin();
-
   mlx.writeTempMin(0);
   mlx.writeTempMax(125);
 
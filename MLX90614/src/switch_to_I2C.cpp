@@ -17,11 +17,10 @@ void setup() {
     while (1);
   };
 
-  mlx.begin();
   Serial.println("Configuring MLX90614 for I2C mode...");
 
   mlx.switchToI2C();
-  if (mlx.getCommunicationMode() == "I2C") {
+  if (mlx.getCommunicationMode() == MLX90614_MODE_I2C) {
     Serial.println("Switched to I2C mode");
   } else {
     Serial.println("Failed to switch to I2C mode");
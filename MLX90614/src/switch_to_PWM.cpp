@@ -17,11 +17,10 @@ void setup() {
     while (1);
   };
 
-  mlx.begin();
   Serial.println("Configuring MLX90614 for PWM mode...");
 
   mlx.switchToPWM();
-  if (mlx.getCommunicationMode() == "PWM") {
+  if (mlx.getCommunicationMode() == MLX90614_MODE_PWM) {
     Serial.println("Switched to PWM mode");
   } else {
     Serial.println("Failed to switch to PWM mode");
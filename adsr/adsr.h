@@ -2,6 +2,7 @@
 #define ADSR_H
 
 #include <Arduino.h>
+#include "envelope_curve.h"
 
 namespace Synth {
 
@@ -17,7 +18,24 @@ namespace Synth {
 //
 //   env.noteOn();         // Trigger envelope
 //   uint8_t amplitude = env.nextSample();  // Get current level
+//   env.render(levels, 32);               // Or a block of levels at once
 //   env.noteOff();        // Begin release phase
+//
+// Segments are exponential, like an analog (RC) envelope: each sample moves
+// a fixed fraction of the way to a target beyond the segment's end, so
+// attacks are concave and decays and releases fall in constant dB per
+// second. The attack aims at 1 + ATTACK_OVERSHOOT of full scale and decay
+// and release at DECAY_UNDERSHOOT below their end, so every segment ends in
+// finite time; setCurve() trades curvature for linearity.
+//
+// The level is a 32-bit accumulator (output level << 20) stepped by an
+// EnvelopeCurve, so times from a sample up to the full 65 s of the setters
+// are exact at any sample rate. Segment lengths are worked out when a
+// segment starts, on noteOn(), noteOff() and the setters, so render() fills
+// whole runs of a segment without checking the state per sample. The
+// setters do the float maths; starting a segment is integer only (a log2
+// table lookup), so it is safe when render() crosses from attack to decay
+// in an ISR.
 
 enum class EnvelopeState {
     IDLE,
@@ -29,115 +47,136 @@ enum class EnvelopeState {
 
 class ADSR {
 public:
+    // Full scale of the internal level, 255 in the top 12 bits
+    static const int32_t LEVEL_ONE = 255L << 20;
+    static constexpr float ATTACK_OVERSHOOT = 0.3f;
+    static constexpr float DECAY_UNDERSHOOT = 0.0001f;
+
     ADSR(uint32_t sampleRate = 44100)
         : _sampleRate(sampleRate)
         , _state(EnvelopeState::IDLE)
         , _level(0)
-        , _attackRate(0)
-        , _decayRate(0)
+        , _target(0)
+        , _end(0)
+        , _remaining(0)
         , _sustainLevel(180)
-        , _releaseRate(0)
+        , _peak(255)
+        , _timeCents(0)
+        , _attackOvershoot(ATTACK_OVERSHOOT)
+        , _decayUndershoot(DECAY_UNDERSHOOT)
+        , _attackMs(10)
+        , _decayMs(50)
+        , _releaseMs(100)
     {
-        setAttack(10);    // 10ms default
-        setDecay(50);     // 50ms default
-        setRelease(100);  // 100ms default
+        updateCurves();
     }
 
-    // Set attack time in milliseconds
+    // Set attack time in milliseconds (0 to full scale)
     void setAttack(uint16_t ms) {
         _attackMs = ms;
-        if (ms == 0) {
-            _attackRate = 65535;
-        } else {
-            uint32_t samples = ((uint32_t)ms * _sampleRate) / 1000;
-            _attackRate = 65535 / samples;
-        }
+        _attack = makeCurve(ms, _attackOvershoot);
     }
 
-    // Set decay time in milliseconds
+    // Set decay time in milliseconds (full scale to 0, the time to reach
+    // the sustain level is shorter)
     void setDecay(uint16_t ms) {
         _decayMs = ms;
-        if (ms == 0) {
-            _decayRate = 65535;
-        } else {
-            uint32_t samples = ((uint32_t)ms * _sampleRate) / 1000;
-            _decayRate = 65535 / samples;
-        }
+        _decay = makeCurve(ms, _decayUndershoot);
     }
 
     // Set sustain level (0-255)
     void setSustain(uint8_t level) {
         _sustainLevel = level;
+        if (_state == EnvelopeState::SUSTAIN) {
+            _level = sustainLevel();
+        } else if (_state == EnvelopeState::DECAY) {
+            startSegment(EnvelopeState::DECAY);
+        }
     }
 
-    // Set release time in milliseconds
+    // Set release time in milliseconds (full scale to 0)
     void setRelease(uint16_t ms) {
         _releaseMs = ms;
-        if (ms == 0) {
-            _releaseRate = 65535;
-        } else {
-            uint32_t samples = ((uint32_t)ms * _sampleRate) / 1000;
-            _releaseRate = 65535 / samples;
-        }
+        _release = makeCurve(ms, _decayUndershoot);
+    }
+
+    // Curvature: how far past full scale the attack aims (0.3 default, larger
+    // is more linear) and how far past their end decay and release aim
+    // (0.0001 default, -80 dB, larger is more linear)
+    void setCurve(float attackOvershoot, float decayUndershoot) {
+        _attackOvershoot = constrain(attackOvershoot, 0.001f, 4.0f);
+        _decayUndershoot = constrain(decayUndershoot, 0.00001f, 4.0f);
+        updateCurves();
+    }
+
+    // Per-note scaling, e.g. from NoteScaling: the attack peaks at peak
+    // (0-255, sustain scales with it) and every stage takes
+    // 2^(timeCents/1200) times as long. Integer only and applied as each
+    // segment starts, so it is cheap to call on every note-on, unlike the
+    // setters above.
+    void setNoteScaling(uint8_t peak, int16_t timeCents) {
+        _peak = peak;
+        _timeCents = constrain(timeCents, -4800, 4800);
     }
 
-    // Trigger the envelope (note pressed)
+    // Trigger the envelope (note pressed). The attack continues from the
+    // current level, so retriggering a sounding note does not click.
     void noteOn() {
-        _state = EnvelopeState::ATTACK;
-        // Optionally reset level for new attack, or continue from current
-        // _level = 0; // Uncomment for hard reset
+        startSegment(EnvelopeState::ATTACK);
     }
 
     // Release the envelope (note released)
     void noteOff() {
         if (_state != EnvelopeState::IDLE) {
-            _state = EnvelopeState::RELEASE;
-            _releaseStartLevel = _level;
+            startSegment(EnvelopeState::RELEASE);
         }
     }
 
-    // Get next envelope sample (0-255)
-    uint8_t nextSample() {
-        switch (_state) {
-            case EnvelopeState::IDLE:
-                _level = 0;
-                break;
+    // Fill levels with the next count envelope samples (0-255)
+    void render(uint8_t* levels, uint16_t count) {
+        while (count > 0) {
+            if (_state == EnvelopeState::IDLE || _state == EnvelopeState::SUSTAIN) {
+                // Flat until the next event
+                memset(levels, _level >> 20, count);
+                return;
+            }
+            if (_remaining == 0) {
+                finishSegment();
+                continue;
+            }
 
-            case EnvelopeState::ATTACK:
-                _level += _attackRate;
-                if (_level >= 65535) {
-                    _level = 65535;
-                    _state = EnvelopeState::DECAY;
-                }
-                break;
+            // The rest of this segment, or of the buffer
+            uint16_t run = _remaining < count ? _remaining : count;
+            _remaining -= run;
+            count -= run;
 
-            case EnvelopeState::DECAY:
-                {
-                    uint16_t sustainLevel16 = (uint16_t)_sustainLevel << 8;
-                    if (_level > sustainLevel16 + _decayRate) {
-                        _level -= _decayRate;
-                    } else {
-                        _level = sustainLevel16;
-                        _state = EnvelopeState::SUSTAIN;
-                    }
+            // Held at the end of the segment: a stretched coefficient only
+            // approximates the scaled time, and a release passing 0 would
+            // wrap to full scale
+            int32_t distance = _level - _target;
+            int32_t end = _end - _target;
+            if (_state == EnvelopeState::ATTACK) {
+                for (uint16_t i = 0; i < run; i++) {
+                    distance -= _coefficient.step(distance);
+                    if (distance > end) distance = end;
+                    *levels++ = (_target + distance) >> 20;
                 }
-                break;
-
-            case EnvelopeState::SUSTAIN:
-                // Level stays at sustain until noteOff
-                break;
-
-            case EnvelopeState::RELEASE:
-                if (_level > _releaseRate) {
-                    _level -= _releaseRate;
-                } else {
-                    _level = 0;
-                    _state = EnvelopeState::IDLE;
+            } else {
+                for (uint16_t i = 0; i < run; i++) {
+                    distance -= _coefficient.step(distance);
+                    if (distance < end) distance = end;
+                    *levels++ = (_target + distance) >> 20;
                 }
-                break;
+            }
+            _level = _target + distance;
         }
+    }
 
-        return _level >> 8; // Return top 8 bits
+    // Get next envelope sample (0-255)
+    uint8_t nextSample() {
+        uint8_t level;
+        render(&level, 1);
+        return level;
     }
 
     // Apply envelope to a sample
@@ -155,26 +194,151 @@ public:
     void reset() {
         _state = EnvelopeState::IDLE;
         _level = 0;
+        _remaining = 0;
+    }
+
+    void setSampleRate(uint32_t rate) {
+        _sampleRate = rate;
+        updateCurves();
     }
 
     EnvelopeState getState() const { return _state; }
-    uint8_t getLevel() const { return _level >> 8; }
+    uint8_t getLevel() const { return _level >> 20; }
     bool isActive() const { return _state != EnvelopeState::IDLE; }
 
     uint16_t getAttack() const { return _attackMs; }
     uint16_t getDecay() const { return _decayMs; }
     uint8_t getSustain() const { return _sustainLevel; }
     uint16_t getRelease() const { return _releaseMs; }
+    uint8_t getPeak() const { return _peak; }
+    int16_t getTimeScale() const { return _timeCents; }
 
 private:
+    // A full-scale segment: its coefficient, how far past its end it aims
+    // and how long it takes per octave of distance to its target covered
+    struct Curve {
+        EnvelopeCurve coefficient;
+        uint32_t overshoot;        // Fraction of full scale, 1/2^20
+        uint32_t octaveSamples;    // 1/256 sample
+    };
+
+    Curve makeCurve(uint16_t ms, float ratio) const {
+        Curve curve;
+        uint32_t samples = ((uint32_t)ms * _sampleRate) / 1000;
+        if (samples == 0) samples = 1;
+        curve.coefficient.set(samples, ratio);
+        curve.overshoot = (uint32_t)(ratio * 1048576.0f + 0.5f);
+
+        // The distance to the target shrinks by (1 + ratio) / ratio over
+        // the segment, log2 of that many octaves
+        float octaveSamples = samples * (256 * 0.6931472f) / log((1.0f + ratio) / ratio);
+        curve.octaveSamples = octaveSamples < 4294967040.0f ? (uint32_t)octaveSamples : 0xFFFFFFFFUL;
+        return curve;
+    }
+
+    void updateCurves() {
+        setAttack(_attackMs);
+        setDecay(_decayMs);
+        setRelease(_releaseMs);
+    }
+
+    int32_t peakLevel() const {
+        return (int32_t)_peak << 20;
+    }
+
+    int32_t sustainLevel() const {
+        return (int32_t)(((uint16_t)_sustainLevel * (_peak + 1)) >> 8) << 20;
+    }
+
+    const Curve& currentCurve() const {
+        if (_state == EnvelopeState::ATTACK) return _attack;
+        if (_state == EnvelopeState::DECAY) return _decay;
+        return _release;
+    }
+
+    // Enter a segment from the current level: set its target and the
+    // number of samples until it reaches its end
+    void startSegment(EnvelopeState state) {
+        _state = state;
+        const Curve& curve = currentCurve();
+        // Distance from the end of the segment to its target
+        int32_t end = (int32_t)_peak * curve.overshoot;
+        int32_t start;
+
+        _coefficient = curve.coefficient;
+        if (_timeCents != 0) {
+            _coefficient = curve.coefficient.stretched(_timeCents);
+        }
+
+        if (state == EnvelopeState::ATTACK) {
+            _end = peakLevel();
+            _target = _end + end;
+            start = _target - _level;
+        } else if (state == EnvelopeState::DECAY) {
+            _end = sustainLevel();
+            _target = _end - end;
+            start = _level - _target;
+        } else {
+            _end = 0;
+            _target = -end;
+            start = _level - _target;
+        }
+
+        if (start <= end || end == 0) {
+            // Already at (or past) the end, or a silent note
+            _remaining = 0;
+            return;
+        }
+        // A partial segment takes its share of the full-scale time, in
+        // proportion to the log of the distance it covers. Rounded down and
+        // one short, so the curve never passes its end before finishSegment()
+        // lands on it.
+        int32_t octaves = octavesOf(start) - octavesOf(end);
+        _remaining = ((uint64_t)octaves * curve.octaveSamples) >> 24;
+        if (_timeCents != 0) {
+            _remaining = scaleByCents(_remaining, _timeCents);
+        }
+        if (_remaining > 0) _remaining--;
+    }
+
+    // Land exactly on the end of the segment and move to the next one
+    void finishSegment() {
+        switch (_state) {
+            case EnvelopeState::ATTACK:
+                _level = peakLevel();
+                startSegment(EnvelopeState::DECAY);
+                break;
+
+            case EnvelopeState::DECAY:
+                _level = sustainLevel();
+                _state = EnvelopeState::SUSTAIN;
+                break;
+
+            case EnvelopeState::RELEASE:
+                _level = 0;
+                _state = EnvelopeState::IDLE;
+                break;
+
+            default:
+                break;
+        }
+    }
+
     uint32_t _sampleRate;
     EnvelopeState _state;
-    uint16_t _level;           // 16-bit internal resolution
-    uint16_t _attackRate;
-    uint16_t _decayRate;
+    int32_t _level;            // LEVEL_ONE = full scale
+    int32_t _target;           // Where the current segment is heading
+    int32_t _end;              // Where it stops
+    uint32_t _remaining;       // Samples left in the current segment
     uint8_t _sustainLevel;
-    uint16_t _releaseRate;
-    uint16_t _releaseStartLevel;
+    uint8_t _peak;
+    int16_t _timeCents;
+    EnvelopeCurve _coefficient;    // Current segment, with time scaling
+    float _attackOvershoot;
+    float _decayUndershoot;
+    Curve _attack;
+    Curve _decay;
+    Curve _release;
 
     // Store original ms values for getters
     uint16_t _attackMs;
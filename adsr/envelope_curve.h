@@ -0,0 +1,111 @@
+#ifndef ENVELOPE_CURVE_H
+#define ENVELOPE_CURVE_H
+
+#include <Arduino.h>
+#include "table_gen.h"
+
+namespace Synth {
+
+// Exponential envelope segment coefficient
+//
+// An RC-style segment moves the level a fixed fraction of its distance to
+// a target every sample. The target lies past the end of the segment by
+// ratio * (segment span), so the distance shrinks from (1 + ratio) to ratio
+// spans and the segment ends in finite time: small ratios give a strongly
+// curved (analog) shape, large ones approach a straight line. Run in
+// reverse, the distance from an origin behind the start grows from ratio
+// to (1 + ratio) spans, which gives the slow-start mirror image.
+//
+// The fraction is kept as a normalised 16-bit mantissa and a shift, so a
+// step is two 16x16 multiplies on a 32-bit level, and segments of a
+// single sample up to minutes at audio rate keep their exact length.
+// Used by ADSR and SegmentEnvelope.
+
+struct EnvelopeCurve {
+    uint16_t mantissa;      // Fraction = mantissa / 2^(16 + shift)
+    uint8_t shift;
+
+    // Coefficient for a segment of samples samples with the given ratio,
+    // shrinking the distance (growing = false) or growing it
+    void set(uint32_t samples, float ratio, bool growing = false) {
+        if (samples == 0) samples = 1;
+        // The distance changes by a factor ratio / (1 + ratio) (or its
+        // inverse) over the segment: per sample exp(x) (or exp(-x)). For
+        // long segments the fraction is tiny and 1 - exp(x) loses it in
+        // float, so use the series there.
+        float x = log(ratio / (1.0f + ratio)) / samples;
+        float fraction;
+        if (growing) {
+            fraction = x > -0.01f ? -x * (1.0f - x * 0.5f + x * x / 6.0f) : exp(-x) - 1.0f;
+        } else {
+            fraction = x > -0.01f ? -x * (1.0f + x * 0.5f + x * x / 6.0f) : 1.0f - exp(x);
+        }
+        setFraction(fraction);
+    }
+
+    // Normalise to a 16-bit mantissa in [2^15, 2^16). Fractions of 1 and
+    // more (very short growing segments) are held just below 1.
+    void setFraction(float fraction) {
+        shift = 0;
+        while (fraction < 0.5f && shift < 30) {
+            fraction *= 2.0f;
+            shift++;
+        }
+        uint32_t scaled = (uint32_t)(fraction * 65536.0f + 0.5f);
+        mantissa = scaled > 0xFFFF ? 0xFFFF : scaled;
+    }
+
+    // The same shape 2^(cents/1200) times as long (cents within +/- 4800):
+    // the fraction divided by that factor, with integer maths only. Exact
+    // for long segments; segments of a few samples come out a few percent
+    // off, which the envelopes hide by ending on a sample count.
+    EnvelopeCurve stretched(int16_t cents) const {
+        uint32_t scaled = scaleByCents((uint32_t)mantissa << 8, -constrain(cents, -4800, 4800));
+        int8_t bits = shift + 8;
+        while (scaled >= 0x10000UL) {
+            scaled >>= 1;
+            bits--;
+        }
+        while (scaled < 0x8000UL) {
+            scaled <<= 1;
+            bits++;
+        }
+
+        EnvelopeCurve curve;
+        if (bits < 0) {
+            // A fraction of 1 or more, held just below 1 as in setFraction()
+            curve.mantissa = 0xFFFF;
+            curve.shift = 0;
+        } else {
+            curve.mantissa = scaled;
+            curve.shift = bits > 30 ? 30 : bits;
+        }
+        return curve;
+    }
+
+    // distance * fraction in 16x16 multiplies
+    int32_t step(int32_t distance) const {
+        int16_t high = distance >> 16;
+        uint16_t low = distance;
+        int32_t scaled = (int32_t)high * mantissa
+                       + (int32_t)(((uint32_t)low * mantissa) >> 16);
+        return scaled >> shift;
+    }
+
+    // step() with the bits it drops carried to the next call (carry starts
+    // at 0), so small distances still move. Growing segments need this:
+    // they start a tiny distance from their origin, where a truncated step
+    // would be 0 for thousands of samples.
+    int32_t step(int32_t distance, uint32_t& carry) const {
+        int16_t high = distance >> 16;
+        uint16_t low = distance;
+        int32_t scaled = (int32_t)high * mantissa
+                       + (int32_t)(((uint32_t)low * mantissa) >> 16) + (int32_t)carry;
+        carry = (uint32_t)scaled & ((1UL << shift) - 1);
+        return scaled >> shift;
+    }
+};
+
+} // namespace Synth
+
+#endif // ENVELOPE_CURVE_H
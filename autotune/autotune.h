@@ -0,0 +1,452 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+namespace Thermal {
+
+// Heater autotuning
+//
+// Identifies a first-order-plus-dead-time (FOPDT) model of a heater zone
+//   G(s) = K * exp(-theta * s) / (tau * s + 1)
+// and derives PID gains from it with the IMC rules (Rivera et al.).
+//
+// Two experiments are available:
+//   RelayAutotuner - Astrom-Hagglund relay feedback around the setpoint.
+//                    Gives the ultimate gain/period, the static gain comes
+//                    from the mean temperature rise over the mean duty.
+//   StepAutotuner  - Open-loop step from a cold, settled zone. The model is
+//                    fitted from the 28.3% / 63.2% rise times (Smith).
+//
+// Both take temperatures in centi-degrees C and return a duty (0-65535) for
+// HeaterOutputISR, like PID::update(). Model fitting runs once at the end of
+// the experiment, so it uses floats; the per-sample path is integer only.
+//
+// Usage:
+//   RelayAutotuner tuner;
+//   tuner.begin(4000, 65535);          // oscillate around 40.00 C, full power
+//   while (!tuner.isDone()) {
+//       heater.setDuty(ch, tuner.update(readCentiC(), millis()));
+//   }
+//   if (tuner.getState() == AutotuneState::DONE) {
+//       saveTuning(0, tuner.getResult());
+//       pid.setTunings(tuner.getResult().kp, ...);
+//   }
+
+// Identified heater model
+struct ThermalModel {
+    float gain;          // Steady-state rise in degrees C per unit duty (0-1)
+    float timeConstant;  // Seconds
+    float deadTime;      // Seconds
+};
+
+// Model plus the PID gains derived from it, in PID::setTunings() units
+struct Tuning {
+    ThermalModel model;
+    float kp;
+    float ki;
+    float kd;
+};
+
+enum class AutotuneState {
+    IDLE,
+    RUNNING,
+    DONE,
+    FAILED
+};
+
+// IMC PID rules for a FOPDT model.
+// lambda (closed-loop time constant) defaults to max(0.8 * theta, 0.2 * tau),
+// the fast end of the range that stays robust to dead-time error.
+inline bool tuningFromModel(const ThermalModel& model, Tuning& tuning, float lambda = 0.0f) {
+    float k = model.gain;
+    float tau = model.timeConstant;
+    float theta = model.deadTime;
+    if (k <= 0.0f || tau <= 0.0f || theta < 0.0f) return false;
+
+    if (lambda <= 0.0f) {
+        lambda = max(0.8f * theta, 0.2f * tau);
+    }
+
+    float kc = (tau + 0.5f * theta) / (k * (lambda + 0.5f * theta));
+    float ti = tau + 0.5f * theta;
+    float td = (tau * theta) / (2.0f * tau + theta);
+
+    tuning.model = model;
+    tuning.kp = kc;
+    tuning.ki = kc / ti;
+    tuning.kd = kc * td;
+    return true;
+}
+
+// Relay feedback autotuner (Astrom-Hagglund)
+// The zone must start cold and settled: the first reading is taken as the
+// ambient baseline for the static gain estimate.
+class RelayAutotuner {
+public:
+    RelayAutotuner()
+        : _state(AutotuneState::IDLE)
+        , _cycles(4)
+        , _hysteresis(25)
+        , _timeoutMs(3600000UL)
+    {}
+
+    // Number of full oscillations to average (after one discarded settling cycle)
+    void setCycles(uint8_t cycles) { _cycles = cycles > 0 ? cycles : 1; }
+
+    // Switching hysteresis in centi-degrees, should exceed the sensor noise
+    void setHysteresis(int32_t centiC) { _hysteresis = centiC > 0 ? centiC : 0; }
+
+    void setTimeout(uint32_t ms) { _timeoutMs = ms; }
+
+    // Start an experiment around setpoint, relay switching between
+    // outputLow and outputHigh (duty 0-65535)
+    void begin(int32_t setpoint, uint16_t outputHigh = 65535, uint16_t outputLow = 0) {
+        _setpoint = setpoint;
+        _outHigh = outputHigh;
+        _outLow = outputLow < outputHigh ? outputLow : 0;
+        _state = AutotuneState::RUNNING;
+        _started = false;
+        _heating = true;
+        _halfCycles = 0;
+        _peakMax = INT32_MIN;
+        _peakMin = INT32_MAX;
+        _sumAmplitude = 0;
+        _sumPeriod = 0;
+        _integralY = 0;
+        _highMs = 0;
+        _measuredMs = 0;
+    }
+
+    // Feed one measurement, returns the duty to apply until the next call
+    uint16_t update(int32_t input, uint32_t nowMs) {
+        if (_state != AutotuneState::RUNNING) return _outLow;
+
+        if (!_started) {
+            _started = true;
+            _ambient = input;
+            _startMs = nowMs;
+            _lastMs = nowMs;
+        }
+
+        if (nowMs - _startMs > _timeoutMs) {
+            _state = AutotuneState::FAILED;
+            return _outLow;
+        }
+
+        // Accumulate mean temperature and duty over the measured cycles
+        if (_halfCycles >= 2) {
+            uint32_t dt = nowMs - _lastMs;
+            _integralY += (int64_t)(input - _ambient) * dt;
+            _measuredMs += dt;
+            if (_heating) _highMs += dt;
+        }
+        _lastMs = nowMs;
+
+        if (input > _peakMax) _peakMax = input;
+        if (input < _peakMin) _peakMin = input;
+
+        if (_heating && input > _setpoint + _hysteresis) {
+            _heating = false;
+            _halfCycles++;
+        } else if (!_heating && input < _setpoint - _hysteresis) {
+            // A full oscillation ends each time the relay switches back on
+            _heating = true;
+            _halfCycles++;
+
+            // Half cycles 1-2 are the rise from ambient and the first swing
+            if (_halfCycles > 2) {
+                _sumAmplitude += _peakMax - _peakMin;
+                _sumPeriod += nowMs - _cycleStartMs;
+            }
+            _cycleStartMs = nowMs;
+            _peakMax = INT32_MIN;
+            _peakMin = INT32_MAX;
+
+            if (_halfCycles >= 2 + 2 * (uint16_t)_cycles) {
+                finish();
+                return _outLow;
+            }
+        }
+
+        return _heating ? _outHigh : _outLow;
+    }
+
+    bool isDone() const {
+        return _state == AutotuneState::DONE || _state == AutotuneState::FAILED;
+    }
+
+    AutotuneState getState() const { return _state; }
+    const Tuning& getResult() const { return _result; }
+
+    // Ultimate gain (duty fraction per degree C) and period (s) of the loop
+    float getUltimateGain() const { return _ku; }
+    float getUltimatePeriod() const { return _pu; }
+
+private:
+    void finish() {
+        float a = (_sumAmplitude / 2.0f) / _cycles / 100.0f;   // C, peak
+        float h = _hysteresis / 100.0f;
+        float d = (_outHigh - _outLow) / 2.0f / 65535.0f;     // duty, peak
+        _pu = (_sumPeriod / (float)_cycles) / 1000.0f;
+
+        // Mean duty (0-1) over the measured cycles
+        float duty = ((float)_outHigh * _highMs + (float)_outLow * (_measuredMs - _highMs))
+                   / 65535.0f / _measuredMs;
+        if (a <= h || _pu <= 0.0f || _measuredMs == 0 || duty <= 0.0f) {
+            _state = AutotuneState::FAILED;
+            return;
+        }
+
+        // Describing function of a relay with hysteresis:
+        //   N(a) = 4d / (pi * a) * exp(-j * asin(h / a))
+        // The magnitude gives Ku, the hysteresis only shifts the phase
+        _ku = 4.0f * d / (PI * a);
+        float omega = 2.0f * PI / _pu;
+
+        ThermalModel model;
+        // Mean rise over mean duty, both from full measured cycles
+        model.gain = ((float)_integralY / _measuredMs / 100.0f) / duty;
+
+        // Match the FOPDT frequency response at the oscillation point
+        float kku = model.gain * _ku;
+        model.timeConstant = kku > 1.0f ? sqrt(kku * kku - 1.0f) / omega : 0.0f;
+        model.deadTime = (PI - atan(omega * model.timeConstant) - asin(h / a)) / omega;
+        if (model.timeConstant <= 0.0f) {
+            // Dead-time dominated: all phase lag comes from theta
+            model.timeConstant = 0.1f * model.deadTime;
+        }
+
+        _state = tuningFromModel(model, _result) ? AutotuneState::DONE : AutotuneState::FAILED;
+    }
+
+    AutotuneState _state;
+    uint8_t _cycles;
+    int32_t _hysteresis;
+    uint32_t _timeoutMs;
+
+    int32_t _setpoint;
+    uint16_t _outHigh;
+    uint16_t _outLow;
+    bool _started;
+    bool _heating;
+    uint16_t _halfCycles;
+    int32_t _ambient;
+    int32_t _peakMax;
+    int32_t _peakMin;
+    int32_t _sumAmplitude;
+    uint32_t _sumPeriod;
+    uint32_t _startMs;
+    uint32_t _lastMs;
+    uint32_t _cycleStartMs;
+    int64_t _integralY;        // Centi-degrees above ambient * ms
+    uint32_t _highMs;          // Time at outputHigh
+    uint32_t _measuredMs;      // Time covered by the integral
+
+    float _ku;
+    float _pu;
+    Tuning _result;
+};
+
+// Open-loop step response autotuner
+// Applies a constant duty to a cold, settled zone and records the response
+// in a fixed buffer (decimated 2:1 whenever it fills), until the
+// temperature stays within a band for the settle time. Settling only counts
+// once the response has left the band around the initial reading, so a dead
+// time longer than the settle time is not mistaken for steady state.
+class StepAutotuner {
+public:
+    static const uint8_t MAX_POINTS = 64;
+
+    StepAutotuner()
+        : _state(AutotuneState::IDLE)
+        , _settleBand(20)
+        , _settleMs(60000UL)
+        , _timeoutMs(3600000UL)
+    {}
+
+    // Steady state: temperature within band (centi-degrees) for ms
+    void setSettling(int32_t bandCentiC, uint32_t ms) {
+        _settleBand = bandCentiC;
+        _settleMs = ms;
+    }
+
+    void setTimeout(uint32_t ms) { _timeoutMs = ms; }
+
+    void begin(uint16_t stepOutput) {
+        _step = stepOutput;
+        _state = stepOutput > 0 ? AutotuneState::RUNNING : AutotuneState::FAILED;
+        _started = false;
+        _count = 0;
+        _stride = 1;
+        _skip = 0;
+        _responding = false;
+    }
+
+    uint16_t update(int32_t input, uint32_t nowMs) {
+        if (_state != AutotuneState::RUNNING) return 0;
+
+        if (!_started) {
+            _started = true;
+            _initial = input;
+            _startMs = nowMs;
+        }
+
+        uint32_t elapsed = nowMs - _startMs;
+        if (elapsed > _timeoutMs) {
+            _state = AutotuneState::FAILED;
+            return 0;
+        }
+
+        record(elapsed, input);
+
+        if (!_responding) {
+            // Still in the dead time
+            if (input - _initial > _settleBand) {
+                _responding = true;
+                _settleRef = input;
+                _settleStartMs = nowMs;
+            }
+        } else if (abs(input - _settleRef) > _settleBand) {
+            _settleRef = input;
+            _settleStartMs = nowMs;
+        } else if (nowMs - _settleStartMs >= _settleMs) {
+            finish(input);
+            return 0;
+        }
+
+        return _step;
+    }
+
+    bool isDone() const {
+        return _state == AutotuneState::DONE || _state == AutotuneState::FAILED;
+    }
+
+    AutotuneState getState() const { return _state; }
+    const Tuning& getResult() const { return _result; }
+
+private:
+    void record(uint32_t elapsed, int32_t input) {
+        if (_skip > 0) {
+            _skip--;
+            return;
+        }
+
+        if (_count == MAX_POINTS) {
+            // Keep every other point and halve the recording rate
+            for (uint8_t i = 0; i < MAX_POINTS / 2; i++) {
+                _times[i] = _times[i * 2];
+                _values[i] = _values[i * 2];
+            }
+            _count = MAX_POINTS / 2;
+            _stride *= 2;
+        }
+
+        _times[_count] = elapsed;
+        _values[_count] = input - _initial;
+        _count++;
+        _skip = _stride - 1;
+    }
+
+    // Time (ms) at which the recorded response first reaches level
+    float crossingTime(int32_t level) const {
+        for (uint8_t i = 1; i < _count; i++) {
+            if (_values[i] >= level) {
+                int32_t dv = _values[i] - _values[i - 1];
+                float frac = dv > 0 ? (float)(level - _values[i - 1]) / dv : 1.0f;
+                return _times[i - 1] + frac * (_times[i] - _times[i - 1]);
+            }
+        }
+        return -1.0f;
+    }
+
+    void finish(int32_t input) {
+        int32_t rise = input - _initial;
+        if (rise <= 0) {
+            _state = AutotuneState::FAILED;
+            return;
+        }
+
+        float t28 = crossingTime((rise * 283L) / 1000);
+        float t63 = crossingTime((rise * 632L) / 1000);
+        if (t28 < 0.0f || t63 <= t28) {
+            _state = AutotuneState::FAILED;
+            return;
+        }
+
+        ThermalModel model;
+        model.gain = (rise / 100.0f) / (_step / 65535.0f);
+        model.timeConstant = 1.5f * (t63 - t28) / 1000.0f;
+        model.deadTime = max(t63 / 1000.0f - model.timeConstant, 0.0f);
+
+        _state = tuningFromModel(model, _result) ? AutotuneState::DONE : AutotuneState::FAILED;
+    }
+
+    AutotuneState _state;
+    int32_t _settleBand;
+    uint32_t _settleMs;
+    uint32_t _timeoutMs;
+
+    uint16_t _step;
+    bool _started;
+    int32_t _initial;
+    uint32_t _startMs;
+    bool _responding;          // Left the initial band
+    int32_t _settleRef;
+    uint32_t _settleStartMs;
+
+    uint32_t _times[MAX_POINTS];   // ms since the step
+    int32_t _values[MAX_POINTS];   // centi-degrees above the initial reading
+    uint8_t _count;
+    uint16_t _stride;
+    uint16_t _skip;
+
+    Tuning _result;
+};
+
+// EEPROM persistence of a Tuning record
+// Layout: magic (2), version (1), Tuning, checksum (1)
+const uint16_t TUNING_MAGIC = 0x5455; // "TU"
+const uint8_t TUNING_VERSION = 1;
+
+struct StoredTuning {
+    uint16_t magic;
+    uint8_t version;
+    Tuning tuning;
+    uint8_t checksum;
+};
+
+inline uint8_t tuningChecksum(const StoredTuning& stored) {
+    const uint8_t* p = (const uint8_t*)&stored;
+    uint8_t sum = 0;
+    for (size_t i = 0; i < offsetof(StoredTuning, checksum); i++) {
+        sum = (sum << 1 | sum >> 7) ^ p[i];
+    }
+    return sum;
+}
+
+// Store a tuning at an EEPROM address (only changed bytes are written)
+inline void saveTuning(int address, const Tuning& tuning) {
+    StoredTuning stored;
+    memset(&stored, 0, sizeof(stored));
+    stored.magic = TUNING_MAGIC;
+    stored.version = TUNING_VERSION;
+    stored.tuning = tuning;
+    stored.checksum = tuningChecksum(stored);
+    EEPROM.put(address, stored);
+}
+
+// Load a tuning, returns false if the slot is blank or corrupt
+inline bool loadTuning(int address, Tuning& tuning) {
+    StoredTuning stored;
+    EEPROM.get(address, stored);
+    if (stored.magic != TUNING_MAGIC || stored.version != TUNING_VERSION) return false;
+    if (stored.checksum != tuningChecksum(stored)) return false;
+    tuning = stored.tuning;
+    return true;
+}
+
+} // namespace Thermal
+
+#endif // AUTOTUNE_H
@@ -0,0 +1,129 @@
+#ifndef CONTROL_RATE_H
+#define CONTROL_RATE_H
+
+#include <Arduino.h>
+
+namespace Synth {
+
+// Control-rate modulators
+//
+// Envelopes and LFOs move far slower than audio, so computing them every
+// sample wastes most of the ISR budget. ControlRate<Modulator> runs a
+// modulator (ADSR, LFO, anything with nextSample()) once per block of
+// 2^BLOCK_SHIFT samples, at sampleRate / 2^BLOCK_SHIFT, and ControlRamp
+// interpolates linearly between the control points inside the block. Each
+// audio sample then costs a counter decrement and a 32-bit add instead of
+// a full modulator update, and the output still moves in steps of at most
+// (change per block) / 2^BLOCK_SHIFT, so there is no zipper noise.
+//
+// The ramp heads for the newest control point over the following block,
+// so the output lags the modulator by one block (0.36 ms for 16 samples at
+// 44.1 kHz). sync() starts a new block on the next sample, e.g. right
+// after noteOn(). Times set on the modulator (attack, rate) are still in
+// ms and Hz: it is constructed with the control rate and converts them.
+//
+// Usage:
+//   ControlRate<ADSR> env(22050);                // ADSR ticks at 1378 Hz
+//   ControlRate<LFO> vibrato(22050);
+//   env.modulator().setAttack(20);
+//   vibrato.modulator().setRate(5.0);
+//   env.modulator().noteOn(); env.sync();
+//   ISR: osc.modulatePitch(vibrato.nextSampleCents(30));
+//        out = ((uint16_t)osc.nextSample() * env.nextSample()) >> 8;
+
+// Linear ramp between control points, 16.16 fixed point
+template <uint8_t BLOCK_SHIFT = 4>
+class ControlRamp {
+    static_assert(BLOCK_SHIFT <= 7, "Blocks are at most 128 samples");
+
+public:
+    static const uint8_t BLOCK_SIZE = 1 << BLOCK_SHIFT;
+
+    ControlRamp()
+        : _value(0)
+        , _step(0)
+    {}
+
+    void reset(int16_t value) {
+        _value = (int32_t)value * 65536L;
+        _step = 0;
+    }
+
+    // Ramp from the current value to target over the next BLOCK_SIZE
+    // samples. The step is measured from where the ramp actually is, so
+    // rounding never accumulates across blocks.
+    void setTarget(int16_t target) {
+        _step = ((int32_t)target * 65536L - _value) >> BLOCK_SHIFT;
+    }
+
+    int16_t next() {
+        _value += _step;
+        return (int16_t)((_value + 0x8000) >> 16);
+    }
+
+    int16_t getValue() const { return (int16_t)((_value + 0x8000) >> 16); }
+
+private:
+    int32_t _value;
+    int32_t _step;
+};
+
+// Runs Modulator at sampleRate / 2^BLOCK_SHIFT and ramps between its
+// outputs. Use either nextSample() or nextSampleCents() on one instance,
+// they share the ramp.
+template <class Modulator, uint8_t BLOCK_SHIFT = 4>
+class ControlRate {
+public:
+    static const uint8_t BLOCK_SIZE = 1 << BLOCK_SHIFT;
+
+    ControlRate(uint32_t sampleRate = 44100)
+        : _modulator(sampleRate >> BLOCK_SHIFT)
+        , _remaining(0)
+    {}
+
+    // The modulator itself, for setAttack(), noteOn(), setRate() etc.
+    Modulator& modulator() { return _modulator; }
+
+    void setSampleRate(uint32_t rate) {
+        _modulator.setSampleRate(rate >> BLOCK_SHIFT);
+    }
+
+    // Interpolated Modulator::nextSample() (0-255)
+    uint8_t nextSample() {
+        if (_remaining == 0) {
+            _ramp.setTarget(_modulator.nextSample());
+            _remaining = BLOCK_SIZE;
+        }
+        _remaining--;
+        return (uint8_t)_ramp.next();
+    }
+
+    // Interpolated LFO::nextSampleCents(), for Oscillator::modulatePitch()
+    int16_t nextSampleCents(int16_t maxCents) {
+        if (_remaining == 0) {
+            _ramp.setTarget(_modulator.nextSampleCents(maxCents));
+            _remaining = BLOCK_SIZE;
+        }
+        _remaining--;
+        return _ramp.next();
+    }
+
+    // Take a new control point on the next sample instead of finishing the
+    // current block
+    void sync() { _remaining = 0; }
+
+    // Jump straight to value without ramping (e.g. when a voice is reused)
+    void reset(int16_t value = 0) {
+        _ramp.reset(value);
+        _remaining = 0;
+    }
+
+private:
+    Modulator _modulator;
+    ControlRamp<BLOCK_SHIFT> _ramp;
+    uint8_t _remaining;      // Samples left in the current block
+};
+
+} // namespace Synth
+
+#endif // CONTROL_RATE_H
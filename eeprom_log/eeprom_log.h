@@ -0,0 +1,293 @@
+#ifndef EEPROM_LOG_H
+#define EEPROM_LOG_H
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <avr/eeprom.h>
+#include "log_block.h"
+#include "telemetry.h"
+
+namespace Telemetry {
+
+// Compressed temperature history in EEPROM
+//
+// Readings are logged at a fixed interval into 64 byte blocks (see
+// log_block.h): each sample is a delta from the previous one in a prefix
+// code of 1-6 bits for slow signals, timestamps are implied by the block
+// start and interval. The blocks form a ring over an EEPROM region; the
+// oldest block is overwritten when the region is full.
+//
+// Wear: the block being filled lives in RAM and is written when full, so
+// each EEPROM byte is written once per lap of the ring. flush() saves a
+// partial block early (only changed bytes are rewritten); flushing once a
+// minute at a 10 s interval still gives years of life at 100k cycles.
+// Power loss normally loses the samples since the last flush. If it strikes
+// while a block is being rewritten, that block fails its CRC and all of its
+// samples are lost.
+//
+// Writes never block: a block is copied to a RAM buffer and service()
+// programs one changed byte per call once the EEPROM is ready (each byte
+// takes 3.3 ms), so a full block write is spread over many loop() passes.
+// A second buffer holds the next block while one is still being written
+// (a flush followed at once by a full block).
+//
+// With a 10 s interval the Mega's 4 KB holds roughly a day of history.
+//
+// Readout is non-blocking: startDump() then serviceDump() sends one
+// MSG_LOG_BLOCK frame per stored block, oldest first, as the telemetry ring
+// has room.
+//
+// Usage:
+//   EepromLog history(256, 3840, 10000);    // EEPROM 256-4095, every 10 s
+//   history.begin();
+//   loop() {
+//       history.add(millis(), reading.centiC, reading.valid);
+//       if (minuteElapsed) history.flush();
+//       if (hostAskedForHistory) history.startDump();
+//       history.service();
+//       history.serviceDump(link);
+//   }
+
+class EepromLog {
+public:
+    // Missed slots logged as gaps before starting a new block instead
+    static const uint8_t MAX_GAP_SLOTS = 16;
+
+    EepromLog(uint16_t start = 0, uint16_t size = E2END + 1, uint16_t intervalMs = 10000,
+              uint8_t id = 0)
+        : _start(start)
+        , _blocks(size / LOG_BLOCK_SIZE)
+        , _intervalMs(intervalMs)
+        , _id(id)
+        , _index(0)
+        , _seq(0)
+        , _boot(0)
+        , _count(0)
+        , _previous(LOG_GAP)
+        , _nextMs(0)
+        , _writeIndex(0)
+        , _writeByte(LOG_BLOCK_SIZE)
+        , _queuedIndex(0)
+        , _queued(false)
+        , _dumping(false)
+        , _dumpOldest(0)
+        , _dumpStep(0)
+    {}
+
+    // Find the newest block and continue after it in a new block
+    void begin() {
+        int16_t newest = -1;
+        uint16_t newestSeq = 0;
+
+        for (uint16_t i = 0; i < _blocks; i++) {
+            if (!readBlock(i, _block)) continue;
+            uint16_t seq = logGet(_block, LOG_SEQ, 2);
+            if (newest < 0 || (int16_t)(seq - newestSeq) > 0) {
+                newest = i;
+                newestSeq = seq;
+                _boot = _block[LOG_BOOT];
+            }
+        }
+
+        if (newest >= 0) {
+            _index = (newest + 1) % _blocks;
+            _seq = newestSeq + 1;
+            _boot++;
+        }
+        _count = 0;
+    }
+
+    // Log a reading if its slot is due. Slots missed by a late caller are
+    // logged as gaps so timestamps stay exact. Returns true if logged.
+    bool add(uint32_t nowMs, int32_t value, bool valid = true) {
+        if (_count > 0 && (int32_t)(nowMs - _nextMs) < 0) return false;
+
+        if (!valid) value = LOG_GAP;
+
+        if (_count > 0) {
+            uint32_t missed = (nowMs - _nextMs) / _intervalMs;
+            if (missed > MAX_GAP_SLOTS) {
+                // Long outage: cheaper to restart the timeline in a new block
+                newBlock(nowMs, value);
+                _nextMs = nowMs + _intervalMs;
+                return true;
+            }
+            // Fill the slots between the last sample and this one
+            for (uint32_t i = 0; i < missed; i++) {
+                append(_nextMs, LOG_GAP);
+                _nextMs += _intervalMs;
+            }
+            nowMs = _nextMs;
+        }
+
+        append(nowMs, value);
+        _nextMs = nowMs + _intervalMs;
+        return true;
+    }
+
+    // Queue the partial block for writing so a reset loses little
+    void flush() {
+        if (_count > 0) writeBlock();
+    }
+
+    // Program at most one changed byte of the queued blocks, and only when
+    // the EEPROM is ready. Call every loop, returns true while writing.
+    bool service() {
+        for (;;) {
+            if (_writeByte >= LOG_BLOCK_SIZE) {
+                if (!_queued) return false;
+                // Move on to the block waiting behind the one just written
+                memcpy(_pending, _next, LOG_BLOCK_SIZE);
+                _writeIndex = _queuedIndex;
+                _writeByte = 0;
+                _queued = false;
+            }
+            if (!eeprom_is_ready()) return true;
+            uint16_t address = _start + _writeIndex * LOG_BLOCK_SIZE + _writeByte;
+            uint8_t value = _pending[_writeByte++];
+            if (EEPROM.read(address) != value) {
+                EEPROM.write(address, value);
+                return true;
+            }
+        }
+    }
+
+    bool isWriting() const { return _writeByte < LOG_BLOCK_SIZE || _queued; }
+
+    // Start sending the stored history, oldest block first
+    void startDump() {
+        flush();
+        _dumping = true;
+        _dumpStep = 0;
+        // Pinned so a block started during the dump cannot shift it: the
+        // block after the newest one, which is the current block once
+        // it has been written
+        _dumpOldest = _count > 0 ? (_index + 1) % _blocks : _index;
+    }
+
+    // Send stored blocks while the link has room, false once finished
+    template <uint16_t SIZE>
+    bool serviceDump(Link<SIZE>& link) {
+        uint8_t block[LOG_BLOCK_SIZE];
+
+        while (_dumping && link.canSend(LOG_BLOCK_SIZE + 1)) {
+            if (_dumpStep >= _blocks) {
+                _dumping = false;
+                break;
+            }
+
+            uint16_t index = (_dumpOldest + _dumpStep) % _blocks;
+            _dumpStep++;
+            if (!loadBlock(index, block)) continue;
+
+            link.begin(MSG_LOG_BLOCK);
+            link.putU8(_id);
+            link.putBytes(block, LOG_BLOCK_SIZE);
+            link.end();
+        }
+        return _dumping;
+    }
+
+    bool isDumping() const { return _dumping; }
+    uint16_t getBlocks() const { return _blocks; }
+    uint16_t getInterval() const { return _intervalMs; }
+
+    // Samples in the block being filled
+    uint16_t getCount() const { return _count; }
+
+private:
+    void append(uint32_t timeMs, int32_t value) {
+        if (_count > 0 && _writer.add(_block, _previous, value)) {
+            _count++;
+            if (value != LOG_GAP) _previous = value;
+            return;
+        }
+        newBlock(timeMs, value);
+    }
+
+    // Store the current block (if any) and start the next one with value
+    void newBlock(uint32_t timeMs, int32_t value) {
+        if (_count > 0) {
+            writeBlock();
+            _index = (_index + 1) % _blocks;
+            _seq++;
+        }
+
+        memset(_block, 0, sizeof(_block));
+        logPut(_block, LOG_SEQ, 2, _seq);
+        _block[LOG_BOOT] = _boot;
+        logPut(_block, LOG_START, 4, timeMs);
+        logPut(_block, LOG_FIRST, 4, (uint32_t)value);
+        logPut(_block, LOG_INTERVAL, 2, _intervalMs);
+        _writer.reset();
+        _count = 1;
+        _previous = value;
+    }
+
+    // Queue the current block for service() to write
+    void writeBlock() {
+        logPut(_block, LOG_COUNT, 2, _count);
+        _block[LOG_CRC] = logCrc(_block);
+
+        if (_writeByte < LOG_BLOCK_SIZE && _writeIndex != _index) {
+            // Another block is still being written: wait behind it. Only
+            // one block waits; a newer one replaces it, which takes blocks
+            // completing faster than one every 64 byte writes (0.2 s).
+            memcpy(_next, _block, LOG_BLOCK_SIZE);
+            _queuedIndex = _index;
+            _queued = true;
+            return;
+        }
+        // Idle, or the same block again: (re)start it with the new contents
+        memcpy(_pending, _block, LOG_BLOCK_SIZE);
+        _writeIndex = _index;
+        _writeByte = 0;
+    }
+
+    // A stored block, from the write queue if it is not in EEPROM yet
+    bool loadBlock(uint16_t index, uint8_t* block) const {
+        if (_queued && index == _queuedIndex) {
+            memcpy(block, _next, LOG_BLOCK_SIZE);
+            return logBlockValid(block);
+        }
+        if (_writeByte < LOG_BLOCK_SIZE && index == _writeIndex) {
+            memcpy(block, _pending, LOG_BLOCK_SIZE);
+            return logBlockValid(block);
+        }
+        return readBlock(index, block);
+    }
+
+    bool readBlock(uint16_t index, uint8_t* block) const {
+        uint16_t address = _start + index * LOG_BLOCK_SIZE;
+        for (uint8_t i = 0; i < LOG_BLOCK_SIZE; i++) {
+            block[i] = EEPROM.read(address + i);
+        }
+        return logBlockValid(block);
+    }
+
+    uint16_t _start;
+    uint16_t _blocks;
+    uint16_t _intervalMs;
+    uint8_t _id;
+    uint8_t _block[LOG_BLOCK_SIZE];
+    LogBitWriter _writer;
+    uint16_t _index;
+    uint16_t _seq;
+    uint8_t _boot;
+    uint16_t _count;
+    int32_t _previous;
+    uint32_t _nextMs;
+    uint8_t _pending[LOG_BLOCK_SIZE];    // Block being written by service()
+    uint16_t _writeIndex;
+    uint8_t _writeByte;                  // Next byte to write, LOG_BLOCK_SIZE when idle
+    uint8_t _next[LOG_BLOCK_SIZE];       // Block waiting for _pending to finish
+    uint16_t _queuedIndex;
+    bool _queued;
+    bool _dumping;
+    uint16_t _dumpOldest;
+    uint16_t _dumpStep;
+};
+
+} // namespace Telemetry
+
+#endif // EEPROM_LOG_H
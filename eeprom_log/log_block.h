@@ -0,0 +1,194 @@
+#ifndef LOG_BLOCK_H
+#define LOG_BLOCK_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Compressed history block, shared by EepromLog and the host tools.
+// Plain C++11 with no Arduino dependencies so host code can include it.
+//
+// Block layout (LOG_BLOCK_SIZE bytes, little-endian):
+//   0  seq u16         increments per block, finds the newest block
+//   2  boot u8         increments per begin(), millis() restarts with it
+//   3  start u32       millis() of the first sample
+//   7  first i32       first value, LOG_GAP if there was no reading
+//   11 interval u16    ms between samples
+//   13 count u16       samples in the block, including the first
+//   15 crc u8          CRC-8 over the whole block with this byte as 0
+//   16 payload         one prefix code per sample after the first
+//
+// Sample codes, d = value - previous reading (gaps skipped), z = zigzag(d):
+//   0                  d = 0
+//   10    + 2 bits     z = 1..4       (d = -2..2)
+//   110   + 4 bits     z = 5..20
+//   1110  + 8 bits     z = 21..276
+//   11110              gap, no reading at this slot
+//   11111 + 32 bits    absolute value (no earlier reading in the block, big jumps)
+//
+// A slowly drifting temperature logged in centi-degrees costs 1-6 bits per
+// sample, so a 64 byte block holds around 100 samples.
+
+namespace Telemetry {
+
+const uint8_t LOG_BLOCK_SIZE = 64;
+const uint8_t LOG_HEADER_SIZE = 16;
+const uint16_t LOG_PAYLOAD_BITS = (LOG_BLOCK_SIZE - LOG_HEADER_SIZE) * 8;
+const int32_t LOG_GAP = INT32_MIN;
+
+enum LogField : uint8_t {
+    LOG_SEQ = 0,
+    LOG_BOOT = 2,
+    LOG_START = 3,
+    LOG_FIRST = 7,
+    LOG_INTERVAL = 11,
+    LOG_COUNT = 13,
+    LOG_CRC = 15
+};
+
+inline uint32_t logGet(const uint8_t* block, uint8_t offset, uint8_t bytes) {
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < bytes; i++) value |= (uint32_t)block[offset + i] << (8 * i);
+    return value;
+}
+
+inline void logPut(uint8_t* block, uint8_t offset, uint8_t bytes, uint32_t value) {
+    for (uint8_t i = 0; i < bytes; i++) block[offset + i] = value >> (8 * i);
+}
+
+// CRC-8 (polynomial 0x07) over the block, skipping the crc byte
+inline uint8_t logCrc(const uint8_t* block) {
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < LOG_BLOCK_SIZE; i++) {
+        crc ^= i == LOG_CRC ? 0 : block[i];
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// True if the block holds data and was written completely
+inline bool logBlockValid(const uint8_t* block) {
+    uint16_t count = logGet(block, LOG_COUNT, 2);
+    return count > 0 && count <= LOG_PAYLOAD_BITS + 1 && logCrc(block) == block[LOG_CRC];
+}
+
+inline uint32_t logZigzag(int32_t d) {
+    return ((uint32_t)d << 1) ^ (uint32_t)(d >> 31);
+}
+
+inline int32_t logUnzigzag(uint32_t z) {
+    return (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+}
+
+// Writes sample codes into a block payload
+class LogBitWriter {
+public:
+    LogBitWriter() : _bits(0) {}
+
+    void reset() { _bits = 0; }
+    uint16_t used() const { return _bits; }
+
+    // Bits needed to code value after the previous reading in the block
+    // (either may be LOG_GAP)
+    static uint8_t codeBits(int32_t previous, int32_t value) {
+        if (value == LOG_GAP) return 5;
+        if (previous == LOG_GAP) return 37;
+        int64_t d = (int64_t)value - previous;
+        if (d < INT32_MIN || d > INT32_MAX) return 37;
+        uint32_t z = logZigzag((int32_t)d);
+        if (z == 0) return 1;
+        if (z <= 4) return 4;
+        if (z <= 20) return 7;
+        if (z <= 276) return 12;
+        return 37;
+    }
+
+    // Append the code for value to block, false if it does not fit
+    bool add(uint8_t* block, int32_t previous, int32_t value) {
+        uint8_t bits = codeBits(previous, value);
+        if (_bits + bits > LOG_PAYLOAD_BITS) return false;
+
+        if (value == LOG_GAP) {
+            put(block, 0x1E, 5);
+        } else if (bits == 37) {
+            put(block, 0x1F, 5);
+            put(block, (uint32_t)value, 32);
+        } else {
+            uint32_t z = logZigzag((int32_t)((int64_t)value - previous));
+            if (bits == 1) put(block, 0, 1);
+            else if (bits == 4) { put(block, 0x2, 2); put(block, z - 1, 2); }
+            else if (bits == 7) { put(block, 0x6, 3); put(block, z - 5, 4); }
+            else { put(block, 0xE, 4); put(block, z - 21, 8); }
+        }
+        return true;
+    }
+
+private:
+    void put(uint8_t* block, uint32_t value, uint8_t count) {
+        while (count > 0) {
+            count--;
+            uint16_t byte = LOG_HEADER_SIZE + _bits / 8;
+            uint8_t mask = 0x80 >> (_bits % 8);
+            if ((value >> count) & 1) block[byte] |= mask;
+            else block[byte] &= ~mask;
+            _bits++;
+        }
+    }
+
+    uint16_t _bits;
+};
+
+// Decodes a block, calling visit(timeMs, value) per sample (value may be
+// LOG_GAP). Returns false if the block is invalid or its codes are corrupt.
+template <typename Visit>
+bool decodeLogBlock(const uint8_t* block, Visit visit) {
+    if (!logBlockValid(block)) return false;
+
+    uint32_t time = logGet(block, LOG_START, 4);
+    uint16_t interval = logGet(block, LOG_INTERVAL, 2);
+    uint16_t count = logGet(block, LOG_COUNT, 2);
+    int32_t value = (int32_t)logGet(block, LOG_FIRST, 4);
+    int32_t previous = value;
+    visit(time, value);
+
+    uint16_t bit = 0;
+    auto get = [&](uint8_t n, uint32_t& out) {
+        if (bit + n > LOG_PAYLOAD_BITS) return false;
+        out = 0;
+        for (uint8_t i = 0; i < n; i++, bit++) {
+            out = (out << 1) | ((block[LOG_HEADER_SIZE + bit / 8] >> (7 - bit % 8)) & 1);
+        }
+        return true;
+    };
+
+    for (uint16_t i = 1; i < count; i++) {
+        // Count leading 1s of the prefix (at most 5)
+        uint8_t ones = 0;
+        uint32_t b = 1;
+        while (ones < 5) {
+            if (!get(1, b)) return false;
+            if (!b) break;
+            ones++;
+        }
+
+        uint32_t z;
+        switch (ones) {
+            case 0: value = previous; break;
+            case 1: if (!get(2, z)) return false; value = previous + logUnzigzag(z + 1); break;
+            case 2: if (!get(4, z)) return false; value = previous + logUnzigzag(z + 5); break;
+            case 3: if (!get(8, z)) return false; value = previous + logUnzigzag(z + 21); break;
+            case 4: value = LOG_GAP; break;
+            default: if (!get(32, z)) return false; value = (int32_t)z; break;
+        }
+
+        time += interval;
+        visit(time, value);
+        if (value != LOG_GAP) previous = value;
+    }
+    return true;
+}
+
+} // namespace Telemetry
+
+#endif // LOG_BLOCK_H
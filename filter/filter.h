@@ -31,34 +31,38 @@ public:
 
     // Set cutoff as ratio of sample rate (0.0 to 1.0)
     void setCutoff(float ratio) {
-        // Approximate coefficient from cutoff ratio
-        // Lower ratio = lower cutoff = more filtering
-        if (ratio >= 1.0f) {
-            _coefficient = 0;
-        } else if (ratio <= 0.0f) {
-            _coefficient = 255;
-        } else {
-            _coefficient = (uint8_t)((1.0f - ratio) * 255);
-        }
+        _coefficient = cutoffCoefficient(ratio);
     }
 
     // Process sample (8-bit)
     uint8_t process(uint8_t input) {
-        // output = (input * (256-coeff) + lastOutput * coeff) / 256
-        uint16_t temp = (uint16_t)input * (256 - _coefficient);
-        temp += (uint16_t)_lastOutput * _coefficient;
-        _lastOutput = temp >> 8;
+        _lastOutput = step<uint16_t>(input, _lastOutput, _coefficient);
         return _lastOutput;
     }
 
     // Process signed sample
     int8_t processSigned(int8_t input) {
-        int16_t temp = (int16_t)input * (256 - _coefficient);
-        temp += (int16_t)_lastOutputSigned * _coefficient;
-        _lastOutputSigned = temp >> 8;
+        _lastOutputSigned = step<int16_t>(input, _lastOutputSigned, _coefficient);
         return _lastOutputSigned;
     }
 
+    // Approximate coefficient from cutoff ratio
+    // Lower ratio = lower cutoff = more filtering
+    static uint8_t cutoffCoefficient(float ratio) {
+        if (ratio >= 1.0f) return 0;
+        if (ratio <= 0.0f) return 255;
+        return (uint8_t)((1.0f - ratio) * 255);
+    }
+
+    // One filter step in Wide arithmetic:
+    // output = (input * (256-coeff) + lastOutput * coeff) / 256
+    template <typename Wide, typename T>
+    static T step(T input, T lastOutput, uint8_t coeff) {
+        Wide temp = (Wide)input * (256 - coeff);
+        temp += (Wide)lastOutput * coeff;
+        return temp >> 8;
+    }
+
     void reset() {
         _lastOutput = 0;
         _lastOutputSigned = 0;
@@ -70,6 +74,119 @@ private:
     int8_t _lastOutputSigned;
 };
 
+// One-pole low-pass for 32-bit signals (sensor readings, control values)
+// Runs the OnePoleFilter coefficient and step on a 64-bit state that keeps
+// FRACTION_BITS below the input resolution, so heavy filtering does not
+// stall short of the input (8 bits of state would stop up to 255 counts away).
+class OnePoleFilter32 {
+public:
+    static const uint8_t FRACTION_BITS = 8;
+
+    OnePoleFilter32()
+        : _coefficient(128)
+        , _state(0)
+    {}
+
+    // Set filter coefficient (0-255), see OnePoleFilter
+    void setCoefficient(uint8_t coeff) {
+        _coefficient = coeff;
+    }
+
+    // Set cutoff as ratio of sample rate (0.0 to 1.0), see OnePoleFilter
+    void setCutoff(float ratio) {
+        _coefficient = OnePoleFilter::cutoffCoefficient(ratio);
+    }
+
+    int32_t process(int32_t input) {
+        _state = OnePoleFilter::step<int64_t>((int64_t)input << FRACTION_BITS, _state, _coefficient);
+        return output();
+    }
+
+    int32_t output() const {
+        return (_state + (1L << (FRACTION_BITS - 1))) >> FRACTION_BITS;
+    }
+
+    // Start from a value instead of 0 (avoids the ramp up from zero)
+    void reset(int32_t value = 0) {
+        _state = (int64_t)value << FRACTION_BITS;
+    }
+
+private:
+    uint8_t _coefficient;
+    int64_t _state;
+};
+
+// Second-order (biquad) low-pass for 32-bit signals
+// Butterworth by default (q = 0.7071): flat passband and 12dB/octave, so it
+// removes noise better than a one-pole for the same lag at the cutoff.
+// Coefficients are computed once in float and run in Q(COEFF_BITS) fixed
+// point, direct form I with a 64-bit accumulator. Like OnePoleFilter32 the
+// output history keeps FRACTION_BITS extra bits. Inputs should stay within
+// +-2^23 (83886 C in centi-degrees).
+class BiquadLowPass32 {
+public:
+    static const uint8_t COEFF_BITS = 24;
+    static const uint8_t FRACTION_BITS = 8;
+
+    BiquadLowPass32() {
+        setCutoff(0.1f);
+        reset();
+    }
+
+    // Cutoff as ratio of sample rate (0.001 to 0.49), q = resonance
+    void setCutoff(float ratio, float q = 0.7071f) {
+        ratio = constrain(ratio, 0.001f, 0.49f);
+        float w = 2.0f * PI * ratio;
+        float alpha = sin(w) / (2.0f * q);
+        float a0 = 1.0f + alpha;
+        float s = sin(w / 2.0f);
+        const float one = (float)(1L << COEFF_BITS);
+
+        // b = [1, 2, 1] * b0 with 1 + a1 + a2 = 4 * b0, computed from the
+        // small sin^2 term rather than as a difference of large ones. a2 is
+        // derived so the DC gain is exactly one after quantisation.
+        _b0 = (int32_t)lround(s * s / a0 * one);
+        _a1 = (int32_t)lround(-2.0f * cos(w) / a0 * one);
+        _a2 = 4 * _b0 - (1L << COEFF_BITS) - _a1;
+    }
+
+    int32_t process(int32_t input) {
+        int64_t x = (int64_t)input << FRACTION_BITS;
+        int64_t acc = (int64_t)_b0 * (x + 2 * _x1 + _x2)
+                    - (int64_t)_a1 * _y1
+                    - (int64_t)_a2 * _y2
+                    + _error;
+        _x2 = _x1;
+        _x1 = x;
+        _y2 = _y1;
+        _y1 = acc >> COEFF_BITS;
+        // Carry the truncated part into the next sample (error feedback),
+        // otherwise low cutoffs stall short of the input
+        _error = acc - (_y1 << COEFF_BITS);
+        return output();
+    }
+
+    int32_t output() const {
+        return (_y1 + (1L << (FRACTION_BITS - 1))) >> FRACTION_BITS;
+    }
+
+    // Start settled at a value instead of 0
+    void reset(int32_t value = 0) {
+        _x1 = _x2 = _y1 = _y2 = (int64_t)value << FRACTION_BITS;
+        _error = 0;
+    }
+
+private:
+    int32_t _b0;
+    int32_t _a1;
+    int32_t _a2;
+    int64_t _x1;
+    int64_t _x2;
+    int64_t _y1;
+    int64_t _y2;
+    int32_t _error;
+};
+
 // State Variable Filter (SVF)
 // Provides low-pass, high-pass, and band-pass outputs simultaneously
 // Supports resonance for classic synthesizer sounds
@@ -91,6 +208,13 @@ public:
         calculateCoefficients();
     }
 
+    // Set the cutoff from a precomputed f = 2 * sin(pi * cutoff / sampleRate),
+    // e.g. from NoteScaling, skipping the sin() in setCutoff()
+    void setCutoffCoefficient(float f, float cutoff) {
+        _cutoff = cutoff;
+        _f = f;
+    }
+
     // Resonance: 0.0 to 1.0 (higher = more resonant peak)
     void setResonance(float res) {
         _resonance = constrain(res, 0.0f, 0.99f);
@@ -189,6 +313,13 @@ public:
         calculateCoefficients();
     }
 
+    // Set the cutoff from a precomputed pole coefficient (see
+    // calculateCoefficients()), e.g. from NoteScaling, skipping the divide
+    void setCutoffCoefficient(float p, float cutoff) {
+        _cutoff = cutoff;
+        _p = p;
+    }
+
     // Resonance 0.0 to 1.0 (can self-oscillate near 1.0)
     void setResonance(float res) {
         _resonance = constrain(res, 0.0f, 1.0f);
@@ -0,0 +1,151 @@
+#ifndef HEATER_OUTPUT_H
+#define HEATER_OUTPUT_H
+
+#include <Arduino.h>
+
+#define TIMER_USES_HEATER
+#include "timer_alloc.h"
+
+namespace Thermal {
+
+// Time-proportioning heater output driven by a hardware timer
+//
+// Heaters (relays, SSRs, MOSFETs on slow thermal loads) are switched on for
+// a fraction of a fixed window instead of being PWM'd at audio rates. The
+// window is generated by TIMER_HEATER (Timer4 on the Mega, see
+// timer_alloc.h) in CTC mode, so the switching pattern stays exact no
+// matter how long loop() blocks.
+//
+// The timer ticks at 100 Hz by default. With a 100 tick window the heater is
+// switched once per second with 1% resolution. Any digital pin can be used.
+//
+// Usage:
+//   HeaterOutputISR& heater = HeaterOutputISR::instance();
+//   heater.begin();                            // 100 Hz tick, 1 s window
+//   uint8_t ch = heater.attach(HEAT_PIN);
+//   heater.setDuty(ch, pid.update(temperature));
+//
+// The ISR must be defined in the sketch, see the end of this file.
+
+class HeaterOutputISR {
+public:
+    static const uint8_t MAX_CHANNELS = 8;
+    static const uint8_t INVALID_CHANNEL = 0xFF;
+    static const uint16_t MIN_TICK_HZ = F_CPU / 64UL / 65536UL + 1;   // 4 Hz at 16 MHz
+
+    static HeaterOutputISR& instance() {
+        static HeaterOutputISR inst;
+        return inst;
+    }
+
+    // Start the timer. tickHz is the switching resolution, windowTicks the
+    // number of ticks per time-proportioning window. tickHz is held at or
+    // above MIN_TICK_HZ, where the compare value still fits 16 bits.
+    void begin(uint16_t tickHz = 100, uint16_t windowTicks = 100) {
+        _windowTicks = windowTicks > 0 ? windowTicks : 1;
+        if (tickHz < MIN_TICK_HZ) tickHz = MIN_TICK_HZ;
+        _tick = 0;
+
+        cli();
+
+        // CTC mode (TOP = OCRnA), prescaler 64
+        TIMER_REG(TCCR, TIMER_HEATER, A) = 0;
+        TIMER_REG(TCCR, TIMER_HEATER, B) = (1 << WGM12) | (1 << CS11) | (1 << CS10);
+        TIMER_REG(TCNT, TIMER_HEATER, ) = 0;
+
+        // Compare match = (16MHz / 64 / tickHz) - 1
+        TIMER_REG(OCR, TIMER_HEATER, A) = (F_CPU / 64UL / tickHz) - 1;
+
+        // Enable compare match interrupt
+        TIMER_REG(TIMSK, TIMER_HEATER, ) |= (1 << OCIE1A);
+
+        sei();
+    }
+
+    void end() {
+        TIMER_REG(TIMSK, TIMER_HEATER, ) &= ~(1 << OCIE1A);
+        TIMER_REG(TCCR, TIMER_HEATER, B) = 0;
+        for (uint8_t i = 0; i < _numChannels; i++) {
+            *_ports[i] &= ~_masks[i];
+        }
+    }
+
+    // Register a heater pin, returns its channel or INVALID_CHANNEL if full
+    uint8_t attach(uint8_t pin) {
+        if (_numChannels >= MAX_CHANNELS) return INVALID_CHANNEL;
+
+        pinMode(pin, OUTPUT);
+        digitalWrite(pin, LOW);
+
+        uint8_t ch = _numChannels;
+        uint8_t oldSREG = SREG;
+        cli();
+        _ports[ch] = portOutputRegister(digitalPinToPort(pin));
+        _masks[ch] = digitalPinToBitMask(pin);
+        _duty[ch] = 0;
+        _onTicks[ch] = 0;
+        _numChannels++;
+        SREG = oldSREG;
+        return ch;
+    }
+
+    // Set heater duty (0 = off, 65535 = on for the whole window).
+    // Takes effect at the start of the next window.
+    void setDuty(uint8_t ch, uint16_t duty) {
+        if (ch >= _numChannels) return;
+        uint8_t oldSREG = SREG;
+        cli();
+        _duty[ch] = duty;
+        SREG = oldSREG;
+    }
+
+    uint16_t getDuty(uint8_t ch) const {
+        return ch < _numChannels ? _duty[ch] : 0;
+    }
+
+    uint8_t getNumChannels() const { return _numChannels; }
+    uint16_t getWindowTicks() const { return _windowTicks; }
+
+    // Called from ISR - do not call directly
+    void handleInterrupt() {
+        if (_tick == 0) {
+            // Latch duties once per window so a window is never cut short
+            for (uint8_t i = 0; i < _numChannels; i++) {
+                _onTicks[i] = ((uint32_t)_duty[i] * _windowTicks + 32768UL) >> 16;
+            }
+        }
+
+        for (uint8_t i = 0; i < _numChannels; i++) {
+            if (_tick < _onTicks[i]) {
+                *_ports[i] |= _masks[i];
+            } else {
+                *_ports[i] &= ~_masks[i];
+            }
+        }
+
+        if (++_tick >= _windowTicks) _tick = 0;
+    }
+
+private:
+    HeaterOutputISR() : _numChannels(0), _windowTicks(100), _tick(0) {}
+
+    volatile uint8_t* _ports[MAX_CHANNELS];
+    uint8_t _masks[MAX_CHANNELS];
+    volatile uint16_t _duty[MAX_CHANNELS];
+    uint16_t _onTicks[MAX_CHANNELS];
+    volatile uint8_t _numChannels;
+    uint16_t _windowTicks;
+    uint16_t _tick;
+};
+
+} // namespace Thermal
+
+// Heater timer compare match ISR - must be in global scope
+// Add this to your main sketch if using HeaterOutputISR:
+/*
+ISR(TIMER_HEATER_COMPA_vect) {
+    Thermal::HeaterOutputISR::instance().handleInterrupt();
+}
+*/
+
+#endif // HEATER_OUTPUT_H
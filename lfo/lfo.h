@@ -17,6 +17,9 @@ namespace Synth {
 //
 //   float modulation = lfo.nextSampleBipolar();  // -1.0 to 1.0
 //   float pitchMod = baseFreq * (1.0 + modulation * 0.02);  // +/- 2% pitch bend
+//
+// Integer vibrato, cheap enough for the audio ISR:
+//   osc.modulatePitch(lfo.nextSampleCents(50));  // up to +/- 50 cents at full depth
 
 class LFO {
 public:
@@ -59,7 +62,7 @@ public:
 
         switch (_waveform) {
             case Waveform::SINE:
-                sample = pgm_read_byte(&SINE_TABLE[phaseIndex]);
+                sample = sine8(_phase << 8);
                 break;
 
             case Waveform::SQUARE:
@@ -106,6 +109,12 @@ public:
         return baseFreq * (1.0f + mod);
     }
 
+    // Pitch modulation in cents for Oscillator::modulatePitch(), bipolar,
+    // scaled by depth: +/- maxCents at depth 255
+    int16_t nextSampleCents(int16_t maxCents) {
+        return (int16_t)(((int32_t)nextSampleBipolar() * maxCents) >> 7);
+    }
+
     // Modulate amplitude (for tremolo)
     // Returns amplitude scaled by LFO
     uint8_t modulateAmplitude(uint8_t baseAmp) {
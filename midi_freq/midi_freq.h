@@ -2,6 +2,7 @@
 #define MIDI_FREQ_H
 
 #include <Arduino.h>
+#include "table_gen.h"
 
 namespace Synth {
 
@@ -12,35 +13,17 @@ namespace Synth {
 //   float freq = midiNoteToFrequency(60);  // C4 = 261.63 Hz
 //   uint8_t note = frequencyToMidiNote(440.0);  // A4 = 69
 //   const char* name = noteName(60);  // "C4"
+//   uint32_t inc = NotePitch<22050>::phaseIncrement(60, 25);  // C4 + 25 cents
 
-// Pre-computed frequency table for all 128 MIDI notes
-// Stored as 16-bit fixed point (frequency * 100) to save memory
-// For notes 0-127 (C-1 to G9)
-const uint16_t MIDI_FREQ_TABLE[128] PROGMEM = {
-    // Octave -1 (notes 0-11): C-1 to B-1
-    817, 866, 918, 972, 1030, 1091, 1156, 1225, 1297, 1375, 1457, 1543,
-    // Octave 0 (notes 12-23): C0 to B0
-    1635, 1732, 1835, 1945, 2060, 2183, 2312, 2450, 2596, 2750, 2914, 3087,
-    // Octave 1 (notes 24-35): C1 to B1
-    3270, 3465, 3671, 3889, 4120, 4365, 4625, 4900, 5191, 5500, 5827, 6174,
-    // Octave 2 (notes 36-47): C2 to B2
-    6541, 6930, 7342, 7778, 8241, 8731, 9250, 9800, 10383, 11000, 11654, 12347,
-    // Octave 3 (notes 48-59): C3 to B3
-    13081, 13859, 14683, 15556, 16481, 17461, 18500, 19600, 20765, 22000, 23308, 24694,
-    // Octave 4 (notes 60-71): C4 to B4 - Middle C octave
-    26163, 27718, 29366, 31113, 32963, 34923, 36999, 39200, 41530, 44000, 46616, 49388,
-    // Octave 5 (notes 72-83): C5 to B5
-    52325, 55437, 58733, 62225, 65926, 69846, 73999, 78399, 83061, 88000, 93233, 98777,
-    // Octave 6 (notes 84-95): C6 to B6
-    // Values exceed uint16_t max, stored as freq/10
-    10465, 11087, 11747, 12445, 13185, 13969, 14800, 15680, 16612, 17600, 18647, 19755,
-    // Octave 7 (notes 96-107): C7 to B7 (stored as freq/10)
-    20930, 22175, 23493, 24890, 26370, 27938, 29600, 31360, 33224, 35200, 37293, 39511,
-    // Octave 8 (notes 108-119): C8 to B8 (stored as freq/10)
-    41860, 44349, 46986, 49780, 52740, 55877, 59199, 62719, 66449, 70400, 74586, 79021,
-    // Octave 9 (notes 120-127): C9 to G9 (stored as freq/10)
-    83720, 88698, 93973, 99561, 105481, 111753, 118398, 125439
-};
+// Frequency of all 128 MIDI notes (C-1 to G9), generated at compile time
+// (see table_gen.h). Stored as 32-bit fixed point with 8 fraction bits:
+// 12543.85 Hz at the top still fits, and even the lowest note is within
+// half a cent. 512 bytes of flash.
+const uint8_t MIDI_FREQ_FRACTION_BITS = 8;
+
+typedef GeneratedTable<MidiFrequencyGenerator<MIDI_FREQ_FRACTION_BITS, uint32_t> > MidiFrequencyTable;
+
+static const uint32_t (&MIDI_FREQ_TABLE)[128] = MidiFrequencyTable::values;
 
 // Note names for display
 const char NOTE_NAMES[12][3] PROGMEM = {
@@ -51,14 +34,8 @@ const char NOTE_NAMES[12][3] PROGMEM = {
 inline float midiNoteToFrequency(uint8_t note) {
     if (note > 127) note = 127;
 
-    uint16_t tableValue = pgm_read_word(&MIDI_FREQ_TABLE[note]);
-
-    // Notes 0-83 are stored as freq*100, notes 84-127 as freq/10
-    if (note < 84) {
-        return tableValue / 100.0f;
-    } else {
-        return tableValue * 10.0f;
-    }
+    uint32_t tableValue = pgm_read_dword(&MIDI_FREQ_TABLE[note]);
+    return tableValue / (float)(1UL << MIDI_FREQ_FRACTION_BITS);
 }
 
 // Convert MIDI note to frequency using calculation (more precise but slower)
@@ -136,6 +113,61 @@ inline float detuneByCents(float freq, int16_t cents) {
     return freq * pow(2.0f, cents / 1200.0f);
 }
 
+// Pitch bend in cents, bendValue 0-16383 (8192 = centre), range in semitones.
+// Integer counterpart of applyPitchBend() for NotePitch.
+inline int16_t pitchBendCents(uint16_t bendValue, uint8_t range = 2) {
+    return (int16_t)(((int32_t)bendValue - 8192) * (range * 100) / 8192);
+}
+
+// Ratio 2^(c/1200) for c = 0-100 cents, 1.15 fixed point (202 bytes)
+const uint8_t CENT_RATIO_FRACTION_BITS = 15;
+
+typedef GeneratedTable<Exp2Generator<100, CENT_RATIO_FRACTION_BITS, uint16_t, 100> > CentRatioTable;
+
+// Note + cents -> phase increment, integer only
+//
+// Playing a note through midiNoteToFrequency() and setFrequency() costs a
+// float scale and divide, and every bend or detune adds a pow(). NotePitch
+// goes straight to a 32-bit phase increment for
+// Oscillator::setPhaseIncrement() from two tables generated for the sample
+// rate at compile time:
+//   increment = NOTE_INCREMENT[pitch / 100] * 2^((pitch % 100) / 1200)
+// where pitch = note * 100 + cents. That is a 16-bit divide, two PROGMEM
+// reads and two 16x16 multiplies, so bend and vibrato can be applied at
+// control rate. Resolution is 1 cent; results above Nyquist are held there
+// like setFrequency() does.
+//
+// Usage:
+//   typedef NotePitch<22050> Pitch;              // matches the Oscillator rate
+//   int16_t cents = pitchBendCents(bend) + fineTune;
+//   osc.setPhaseIncrement(Pitch::phaseIncrement(note, cents));
+template <uint32_t SAMPLE_RATE>
+class NotePitch {
+public:
+    typedef GeneratedTable<PhaseIncrementGenerator<SAMPLE_RATE> > IncrementTable;
+
+    // Half a cycle per sample
+    static const uint32_t NYQUIST_INCREMENT = 0x80000000UL;
+
+    // Phase increment of a note offset by cents (clamped to notes 0-127)
+    static uint32_t phaseIncrement(uint8_t note, int16_t cents = 0) {
+        if (note > 127) note = 127;
+        int16_t pitch = (int16_t)note * 100 + constrain(cents, -12700, 12700);
+        if (pitch < 0) pitch = 0;
+        if (pitch > 12700) pitch = 12700;
+
+        uint8_t semitone = (uint16_t)pitch / 100;
+        uint8_t fine = (uint16_t)pitch % 100;
+        uint32_t base = pgm_read_dword(&IncrementTable::values[semitone]);
+        uint16_t ratio = pgm_read_word(&CentRatioTable::values[fine]);
+
+        // base * ratio >> 15, split into 16-bit halves of base
+        uint32_t increment = (((uint32_t)(uint16_t)(base >> 16) * ratio) << 1)
+                           + (((uint32_t)(uint16_t)base * ratio) >> CENT_RATIO_FRACTION_BITS);
+        return increment > NYQUIST_INCREMENT ? NYQUIST_INCREMENT : increment;
+    }
+};
+
 } // namespace Synth
 
 #endif // MIDI_FREQ_H
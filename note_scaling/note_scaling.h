@@ -0,0 +1,171 @@
+#ifndef NOTE_SCALING_H
+#define NOTE_SCALING_H
+
+#include <Arduino.h>
+#include "table_gen.h"
+#include "midi_freq.h"
+#include "adsr.h"
+#include "filter.h"
+
+namespace Synth {
+
+// Velocity and key tracking
+//
+// Works out per-note envelope level, envelope time and filter cutoff from
+// the note and its velocity, using small PROGMEM curves generated at
+// compile time, so a note-on costs a few integer operations and table
+// reads instead of the float setters (setAttack() takes logs,
+// StateVariableFilter::setCutoff() a sin()):
+//   level       velocity curve, linear in dB over VELOCITY_RANGE_DB
+//   time        2^(cents/1200) scaling of every envelope stage, from the
+//               key (e.g. higher notes decay faster) and velocity
+//   cutoff      a note number (semitone steps, 8 Hz to 12.5 kHz) from a
+//               base cutoff, key tracking and velocity, indexing tables
+//               of precomputed SVF and Moog coefficients for SAMPLE_RATE
+// Key tracking is relative to CENTER_NOTE (C4).
+//
+// Usage:
+//   NoteScaling<22050> scaling;
+//   scaling.setCutoff(84);                  // C6, 1047 Hz at C4 and full velocity
+//   scaling.setCutoffKeyTracking(64);       // cutoff follows the key at 50%
+//   scaling.setCutoffVelocity(-24);         // soft notes two octaves darker
+//   scaling.setTimeKeyTracking(-600);       // each octave up decays 30% faster
+//   noteOn(note, velocity):
+//       NoteParameters p = scaling.noteOn(note, velocity);
+//       scaling.apply(p, env);
+//       scaling.apply(p, svf);
+//       env.noteOn();
+
+// Velocity 0-127 to level 0-255, linear in dB over RANGE_DB; velocity 0
+// is silent
+template <uint8_t RANGE_DB = 40>
+struct VelocityCurveGenerator {
+    typedef uint8_t Value;
+    static const uint16_t SIZE = 128;
+
+    static constexpr double exact(uint16_t velocity) {
+        // 20 log10(2) = 6.0206 dB per doubling
+        return velocity == 0 ? 0
+            : 255 * TableMath::exp2((velocity - 127) / 127.0 * RANGE_DB / 6.0206);
+    }
+};
+
+// StateVariableFilter f = 2 * sin(pi * cutoff / SAMPLE_RATE) for a cutoff at
+// each MIDI note frequency (clamped like setCutoff()), 2.14 fixed point
+template <uint32_t SAMPLE_RATE>
+struct SvfCutoffGenerator {
+    typedef uint16_t Value;
+    static const uint16_t SIZE = 128;
+
+    static constexpr double cutoff(uint16_t note) {
+        return TableMath::noteFrequency(note) < 20 ? 20
+            : TableMath::noteFrequency(note) > SAMPLE_RATE / 2.0 ? SAMPLE_RATE / 2.0
+            : TableMath::noteFrequency(note);
+    }
+
+    static constexpr double exact(uint16_t note) {
+        return 16384 * 2 * TableMath::sine(TableMath::PI_DOUBLE * cutoff(note) / SAMPLE_RATE);
+    }
+};
+
+// MoogFilter pole coefficient fc * (1.8 - 0.8 * fc), fc = cutoff /
+// SAMPLE_RATE, for a cutoff at each MIDI note frequency (clamped like
+// setCutoff()), 0.16 fixed point
+template <uint32_t SAMPLE_RATE>
+struct MoogCutoffGenerator {
+    typedef uint16_t Value;
+    static const uint16_t SIZE = 128;
+
+    static constexpr double ratio(uint16_t note) {
+        return TableMath::noteFrequency(note) < 20 ? 20.0 / SAMPLE_RATE
+            : TableMath::noteFrequency(note) > SAMPLE_RATE / 2.5 ? 1 / 2.5
+            : TableMath::noteFrequency(note) / SAMPLE_RATE;
+    }
+
+    static constexpr double exact(uint16_t note) {
+        return 65536 * ratio(note) * (1.8 - 0.8 * ratio(note));
+    }
+};
+
+// Parameters of one note, from NoteScaling::noteOn()
+struct NoteParameters {
+    uint8_t level;          // Envelope peak, 0-255
+    int16_t timeCents;      // Envelope stages take 2^(timeCents/1200) as long
+    uint8_t cutoffNote;     // Filter cutoff as a MIDI note number
+};
+
+template <uint32_t SAMPLE_RATE, uint8_t VELOCITY_RANGE_DB = 40>
+class NoteScaling {
+public:
+    typedef GeneratedTable<VelocityCurveGenerator<VELOCITY_RANGE_DB> > VelocityTable;
+    typedef GeneratedTable<SvfCutoffGenerator<SAMPLE_RATE> > SvfTable;
+    typedef GeneratedTable<MoogCutoffGenerator<SAMPLE_RATE> > MoogTable;
+
+    static const uint8_t CENTER_NOTE = 60;
+
+    NoteScaling()
+        : _cutoffNote(96)
+        , _cutoffKeyTracking(0)
+        , _cutoffVelocity(0)
+        , _timeKeyTracking(0)
+        , _timeVelocity(0)
+    {}
+
+    // Cutoff at the centre note and full velocity, as a MIDI note
+    void setCutoff(uint8_t note) { _cutoffNote = note > 127 ? 127 : note; }
+
+    // How far the cutoff follows the key, 128 = one semitone per semitone
+    void setCutoffKeyTracking(int16_t amount) { _cutoffKeyTracking = amount; }
+
+    // Cutoff change from velocity 127 down to 0, semitones
+    void setCutoffVelocity(int8_t semitones) { _cutoffVelocity = semitones; }
+
+    // Envelope time change per octave above the centre note, cents
+    void setTimeKeyTracking(int16_t centsPerOctave) { _timeKeyTracking = centsPerOctave; }
+
+    // Envelope time change from velocity 127 down to 0, cents
+    void setTimeVelocity(int16_t cents) { _timeVelocity = cents; }
+
+    NoteParameters noteOn(uint8_t note, uint8_t velocity) const {
+        if (note > 127) note = 127;
+        if (velocity > 127) velocity = 127;
+        int16_t key = (int16_t)note - CENTER_NOTE;
+        uint8_t softness = 127 - velocity;
+
+        NoteParameters parameters;
+        parameters.level = pgm_read_byte(&VelocityTable::values[velocity]);
+
+        int16_t cutoff = _cutoffNote + (int16_t)(((int32_t)key * _cutoffKeyTracking) / 128)
+                       + (int16_t)softness * _cutoffVelocity / 127;
+        parameters.cutoffNote = constrain(cutoff, 0, 127);
+
+        int32_t cents = (int32_t)key * _timeKeyTracking / 12 + (int32_t)softness * _timeVelocity / 127;
+        parameters.timeCents = constrain(cents, -4800L, 4800L);
+        return parameters;
+    }
+
+    static void apply(const NoteParameters& parameters, ADSR& envelope) {
+        envelope.setNoteScaling(parameters.level, parameters.timeCents);
+    }
+
+    static void apply(const NoteParameters& parameters, StateVariableFilter& filter) {
+        uint16_t f = pgm_read_word(&SvfTable::values[parameters.cutoffNote]);
+        filter.setCutoffCoefficient(f * (1.0f / 16384), midiNoteToFrequency(parameters.cutoffNote));
+    }
+
+    static void apply(const NoteParameters& parameters, MoogFilter& filter) {
+        uint16_t p = pgm_read_word(&MoogTable::values[parameters.cutoffNote]);
+        filter.setCutoffCoefficient(p * (1.0f / 65536), midiNoteToFrequency(parameters.cutoffNote));
+    }
+
+private:
+    uint8_t _cutoffNote;
+    int16_t _cutoffKeyTracking;
+    int8_t _cutoffVelocity;
+    int16_t _timeKeyTracking;
+    int16_t _timeVelocity;
+};
+
+} // namespace Synth
+
+#endif // NOTE_SCALING_H
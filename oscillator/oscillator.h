@@ -2,6 +2,8 @@
 #define OSCILLATOR_H
 
 #include <Arduino.h>
+#include "sine_table.h"
+#include "wavetables.h"
 
 namespace Synth {
 
@@ -14,26 +16,10 @@ enum class Waveform {
     PULSE
 };
 
-// Pre-computed sine table (256 entries, 8-bit resolution)
-// Values range from 0-255 for unsigned output
-const uint8_t SINE_TABLE[256] PROGMEM = {
-    128,131,134,137,140,143,146,149,152,155,158,162,165,167,170,173,
-    176,179,182,185,188,190,193,196,198,201,203,206,208,211,213,215,
-    218,220,222,224,226,228,230,232,234,235,237,238,240,241,243,244,
-    245,246,248,249,250,250,251,252,253,253,254,254,254,255,255,255,
-    255,255,255,255,254,254,254,253,253,252,251,250,250,249,248,246,
-    245,244,243,241,240,238,237,235,234,232,230,228,226,224,222,220,
-    218,215,213,211,208,206,203,201,198,196,193,190,188,185,182,179,
-    176,173,170,167,165,162,158,155,152,149,146,143,140,137,134,131,
-    128,124,121,118,115,112,109,106,103,100,97,93,90,88,85,82,
-    79,76,73,70,67,65,62,59,57,54,52,49,47,44,42,40,
-    37,35,33,31,29,27,25,23,21,20,18,17,15,14,12,11,
-    10,9,7,6,5,5,4,3,2,2,1,1,1,0,0,0,
-    0,0,0,0,1,1,1,2,2,3,4,5,5,6,7,9,
-    10,11,12,14,15,17,18,20,21,23,25,27,29,31,33,35,
-    37,40,42,44,47,49,52,54,57,59,62,65,67,70,73,76,
-    79,82,85,88,90,93,97,100,103,106,109,112,115,118,121,124
-};
+// Phase increment (up to Nyquist) * 2^(cents / 1200), clamped to Nyquist
+inline uint32_t scaleIncrementByCents(uint32_t increment, int16_t cents) {
+    return scaleByCents(increment, cents, 0x80000000UL);
+}
 
 class Oscillator {
 public:
@@ -41,17 +27,37 @@ public:
         : _sampleRate(sampleRate)
         , _frequency(440.0f)
         , _phase(0)
+        , _baseIncrement(0)
         , _phaseIncrement(0)
         , _waveform(Waveform::SINE)
         , _pulseWidth(128) // 50% duty cycle
     {
         setFrequency(_frequency);
+        setPulseWidth(_pulseWidth);
     }
 
     void setFrequency(float freq) {
         _frequency = freq;
-        // Phase increment for 16-bit phase accumulator (0-65535)
-        _phaseIncrement = (uint16_t)((freq * 65536.0f) / _sampleRate);
+        // Phase increment for the 32-bit phase accumulator: a resolution of
+        // sampleRate / 2^32 (10 uHz at 44.1 kHz), so detuning by cents works
+        float ratio = constrain(freq / _sampleRate, 0.0f, 0.5f);
+        setPhaseIncrement((uint32_t)(ratio * 4294967296.0f));
+    }
+
+    // Set the pitch directly as a fraction of the sample rate * 2^32, e.g.
+    // from NotePitch<rate>::phaseIncrement(note, cents). Clears any pitch
+    // modulation.
+    void setPhaseIncrement(uint32_t increment) {
+        _baseIncrement = increment;
+        applyIncrement(increment);
+    }
+
+    // Pitch modulation input: play cents above (or below) the set pitch
+    // until the next call. Integer only (an interpolated table lookup and a
+    // few multiplies), cheap enough to call every sample from the audio ISR
+    // for vibrato or FM, e.g. modulatePitch(lfo.nextSampleCents(50)).
+    void modulatePitch(int16_t cents) {
+        applyIncrement(scaleIncrementByCents(_baseIncrement, cents));
     }
 
     void setWaveform(Waveform wf) {
@@ -60,6 +66,9 @@ public:
 
     void setPulseWidth(uint8_t pw) {
         _pulseWidth = pw;
+        // Pulse = saw(phase - width) - saw(phase) + offset, the offset
+        // centres it: 128 + amplitude * (2 * width / 256 - 1)
+        _pulseOffset = 128 + (((int16_t)pw * 2 - 256) * WAVETABLE_SAW_AMPLITUDE) / 256;
     }
 
     void setSampleRate(uint32_t rate) {
@@ -69,56 +78,98 @@ public:
 
     // Returns 8-bit sample (0-255)
     uint8_t nextSample() {
-        uint8_t sample = 0;
-        uint8_t phaseIndex = _phase >> 8; // Top 8 bits of phase
+        return (uint8_t)((render() >> 8) + 128);
+    }
+
+    // Returns 16-bit sample (0-65535), for PWMAudio::write16
+    uint16_t nextSample16() {
+        return (uint16_t)render() ^ 0x8000;
+    }
+
+    // Returns signed sample (-128 to 127)
+    int8_t nextSampleSigned() {
+        return (int8_t)(nextSample() - 128);
+    }
+
+    void reset() {
+        _phase = 0;
+    }
+
+    float getFrequency() const { return _frequency; }
+    uint32_t getPhaseIncrement() const { return _phaseIncrement; }
+    Waveform getWaveform() const { return _waveform; }
+
+private:
+    // Signed 16-bit sample at the current phase, then advance the phase
+    int16_t render() {
+        int16_t sample = 0;
 
         switch (_waveform) {
             case Waveform::SINE:
-                sample = pgm_read_byte(&SINE_TABLE[phaseIndex]);
+                sample = sine16(_phase);
                 break;
 
             case Waveform::SQUARE:
-                sample = (phaseIndex < 128) ? 255 : 0;
+                sample = interpolate(_squareTable, _phase) - 32768;
                 break;
 
             case Waveform::SAWTOOTH:
-                sample = phaseIndex;
+                sample = interpolate(_sawTable, _phase) - 32768;
                 break;
 
-            case Waveform::TRIANGLE:
-                sample = (phaseIndex < 128)
-                    ? (phaseIndex * 2)
-                    : (255 - (phaseIndex - 128) * 2);
+            case Waveform::TRIANGLE: {
+                uint16_t position = _phase >> 16;
+                uint16_t triangle = (position < 0x8000)
+                    ? (position * 2)
+                    : (0xFFFF - (position - 0x8000) * 2);
+                sample = triangle - 32768;
                 break;
-
-            case Waveform::PULSE:
-                sample = (phaseIndex < _pulseWidth) ? 255 : 0;
+            }
+
+            case Waveform::PULSE: {
+                // Difference of two band-limited saws, offset by the width
+                int32_t pulse = ((int32_t)_pulseOffset << 8)
+                    + interpolate(_sawTable, _phase - ((uint32_t)_pulseWidth << 24))
+                    - interpolate(_sawTable, _phase);
+                sample = constrain(pulse, 0L, 65535L) - 32768;
                 break;
+            }
         }
 
         _phase += _phaseIncrement;
         return sample;
     }
 
-    // Returns signed sample (-128 to 127)
-    int8_t nextSampleSigned() {
-        return (int8_t)(nextSample() - 128);
-    }
+    void applyIncrement(uint32_t increment) {
+        _phaseIncrement = increment;
 
-    void reset() {
-        _phase = 0;
+        // Band-limited tables with no harmonics above Nyquist at this pitch
+        uint8_t level = wavetableLevel(_phaseIncrement >> 16);
+        _sawTable = SAW_TABLES[level];
+        _squareTable = SQUARE_TABLES[level];
     }
 
-    float getFrequency() const { return _frequency; }
-    Waveform getWaveform() const { return _waveform; }
+    // Linear interpolation between two 8-bit PROGMEM table entries, scaled
+    // to 16 bits: the top 8 bits of the phase pick the entry, the next 8
+    // weight the neighbour. Two unsigned 8x8 multiplies, 255 * 256 fits.
+    static uint16_t interpolate(const uint8_t* table, uint32_t phase) {
+        uint8_t index = phase >> 24;
+        uint8_t fraction = phase >> 16;
+        uint8_t a = pgm_read_byte(&table[index]);
+        uint8_t b = pgm_read_byte(&table[(uint8_t)(index + 1)]);
+        return (uint16_t)a * (uint16_t)(256 - fraction) + (uint16_t)b * fraction;
+    }
 
-private:
     uint32_t _sampleRate;
     float _frequency;
-    uint16_t _phase;
-    uint16_t _phaseIncrement;
+    uint32_t _phase;
+    uint32_t _baseIncrement;        // Set pitch
+    uint32_t _phaseIncrement;       // Set pitch with modulation applied
     Waveform _waveform;
     uint8_t _pulseWidth;
+    int16_t _pulseOffset;
+    const uint8_t* _sawTable;       // PROGMEM, mip level for this pitch
+    const uint8_t* _squareTable;
 };
 
 // Utility function to get waveform name
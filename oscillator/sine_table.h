@@ -0,0 +1,51 @@
+#ifndef SINE_TABLE_H
+#define SINE_TABLE_H
+
+#include <Arduino.h>
+#include "table_gen.h"
+
+namespace Synth {
+
+// Quarter-wave sine table, 16-bit
+//
+// Only the first quarter of the cycle is stored; the other three are
+// mirrored and negated from it. 257 entries (both ends of the quarter
+// included, so interpolation never wraps) of round(32767 * sin(pi/2 * i/256)):
+// 514 bytes of flash for 1024 steps per cycle at 16-bit resolution, against
+// 256 bytes for the old 256 x 8-bit full table. The table is generated at
+// compile time (see table_gen.h).
+//
+// sine16() and sine8() take a 32-bit phase (2^32 = one cycle) and
+// interpolate linearly between entries with an unsigned 16x8 multiply.
+// Oscillator and LFO both read from here.
+
+typedef GeneratedTable<SineQuarterGenerator<256, 16, uint16_t> > SineQuarterTable;
+
+static const uint16_t (&SINE_QUARTER_TABLE)[257] = SineQuarterTable::values;
+
+// Signed sine of a 32-bit phase, -32767 to 32767
+inline int16_t sine16(uint32_t phase) {
+    uint8_t quadrant = phase >> 30;
+    // Position within the quadrant, 8.8 fixed point entries
+    uint32_t position = (phase >> 14) & 0xFFFF;
+    if (quadrant & 1) position = 0x10000UL - position;   // Falling quarters
+
+    uint16_t index = position >> 8;
+    uint8_t fraction = position;
+    uint16_t value = pgm_read_word(&SINE_QUARTER_TABLE[index]);
+    if (fraction) {
+        // Rising table: the step is at most 202, so step * fraction fits 16 bits
+        uint16_t step = pgm_read_word(&SINE_QUARTER_TABLE[index + 1]) - value;
+        value += ((uint16_t)step * fraction) >> 8;
+    }
+    return (quadrant & 2) ? -(int16_t)value : (int16_t)value;
+}
+
+// Unsigned 8-bit sine of a 32-bit phase, 0 to 255 centred on 128
+inline uint8_t sine8(uint32_t phase) {
+    return (uint8_t)((sine16(phase) >> 8) + 128);
+}
+
+} // namespace Synth
+
+#endif // SINE_TABLE_H
@@ -0,0 +1,342 @@
+#ifndef WAVETABLES_H
+#define WAVETABLES_H
+
+#include <Arduino.h>
+
+namespace Synth {
+
+// Band-limited wavetables for the Oscillator
+//
+// A naive sawtooth or square has harmonics far above Nyquist, which fold
+// back as inharmonic aliases on high notes. These tables hold the Fourier
+// series truncated per octave ("mip levels"): level L is used for phase
+// increments below 256 << L (16-bit phase) and contains only harmonics
+// below Nyquist for all of them:
+//   level  0    1   2   3   4   5   6   7
+//   harm  127  64  32  16   8   4   2   1
+// At 44.1 kHz level 0 covers notes up to 172 Hz, and each level one more
+// octave. Selecting the level once in setFrequency() keeps the per-sample
+// cost at one PROGMEM read, the same as the sine table.
+//
+// All levels of a waveform share one scale so the volume does not jump
+// between octaves; the scale leaves room for the Gibbs overshoot of the
+// truncated series (sawtooth +-WAVETABLE_SAW_AMPLITUDE around 128).
+//
+// Sawtooth: x(p) = -2/pi * sum(sin(2 pi h p) / h), rising like the naive one
+// Square:   x(p) = 4/pi * sum(sin(2 pi h p) / h, odd h), high first
+// Entries are round(128 + amplitude * x(i / 256)). 4 KB of flash in total.
+//
+// Pulse waves are built from two sawtooth lookups (see Oscillator).
+
+const uint8_t WAVETABLE_LEVELS = 8;
+const uint8_t WAVETABLE_SAW_AMPLITUDE = 108;
+const uint8_t WAVETABLE_SQUARE_AMPLITUDE = 99;
+
+// Mip level for a 16-bit phase increment
+inline uint8_t wavetableLevel(uint16_t phaseIncrement) {
+    uint8_t level = 0;
+    phaseIncrement >>= 8;
+    while (phaseIncrement && level < WAVETABLE_LEVELS - 1) {
+        phaseIncrement >>= 1;
+        level++;
+    }
+    return level;
+}
+
+const uint8_t SAW_TABLES[WAVETABLE_LEVELS][256] PROGMEM = {
+    { // 127 harmonics
+        128,2,32,15,29,20,29,23,29,25,31,27,32,29,33,31,
+        35,33,36,35,38,37,40,38,41,40,43,42,44,44,46,45,
+        48,47,49,49,51,51,53,52,54,54,56,56,58,58,59,59,
+        61,61,63,63,64,64,66,66,68,68,69,69,71,71,73,73,
+        74,75,76,76,78,78,79,80,81,81,83,83,84,85,86,86,
+        88,88,89,90,91,92,93,93,94,95,96,97,98,98,99,100,
+        101,102,103,103,104,105,106,107,108,109,110,110,111,112,113,114,
+        115,115,116,117,118,119,120,120,121,122,123,124,125,125,126,127,
+        128,129,130,131,131,132,133,134,135,136,136,137,138,139,140,141,
+        141,142,143,144,145,146,146,147,148,149,150,151,152,153,153,154,
+        155,156,157,158,158,159,160,161,162,163,163,164,165,166,167,168,
+        168,170,170,171,172,173,173,175,175,176,177,178,178,180,180,181,
+        182,183,183,185,185,187,187,188,188,190,190,192,192,193,193,195,
+        195,197,197,198,198,200,200,202,202,204,203,205,205,207,207,209,
+        208,211,210,212,212,214,213,216,215,218,216,219,218,221,220,223,
+        221,225,223,227,224,229,225,231,227,233,227,236,227,241,224,254
+    },
+    { // 64 harmonics
+        128,34,2,20,34,25,18,26,32,27,24,30,34,31,29,33,
+        36,34,33,36,39,37,37,40,42,41,40,43,45,44,44,47,
+        48,47,47,50,52,51,51,53,55,54,54,57,58,57,58,60,
+        61,61,61,64,65,64,65,67,68,68,68,70,71,71,72,74,
+        75,74,75,77,78,78,79,80,81,81,82,84,85,84,85,87,
+        88,88,89,91,91,91,92,94,95,95,96,97,98,98,99,101,
+        101,101,102,104,105,105,106,107,108,108,109,111,111,111,113,114,
+        115,115,116,118,118,118,119,121,121,122,123,124,125,125,126,128,
+        128,128,130,131,131,132,133,134,135,135,137,138,138,138,140,141,
+        141,142,143,145,145,145,147,148,148,149,150,151,151,152,154,155,
+        155,155,157,158,158,159,160,161,161,162,164,165,165,165,167,168,
+        168,169,171,172,171,172,174,175,175,176,177,178,178,179,181,182,
+        181,182,184,185,185,186,188,188,188,189,191,192,191,192,195,195,
+        195,196,198,199,198,199,202,202,201,203,205,205,204,206,209,209,
+        208,209,212,212,211,213,216,215,214,216,219,219,217,220,223,222,
+        220,223,227,225,222,226,232,229,224,230,238,231,222,236,254,222
+    },
+    { // 32 harmonics
+        128,76,34,10,4,11,24,34,37,34,28,24,23,27,32,37,
+        39,37,34,32,33,35,39,43,44,43,41,40,41,43,46,49,
+        50,49,48,47,48,50,53,55,56,55,54,54,55,57,60,62,
+        62,62,61,61,62,64,67,68,69,68,68,68,69,71,73,75,
+        75,75,75,75,76,78,80,81,82,81,81,82,83,85,87,88,
+        88,88,88,89,90,92,94,95,95,95,95,96,97,99,100,101,
+        101,101,102,103,104,106,107,108,108,108,108,109,111,113,114,115,
+        115,115,115,116,118,119,121,121,121,121,122,123,125,126,127,128,
+        128,128,129,130,131,133,134,135,135,135,135,137,138,140,141,141,
+        141,141,142,143,145,147,148,148,148,148,149,150,152,153,154,155,
+        155,155,156,157,159,160,161,161,161,161,162,164,166,167,168,168,
+        168,168,169,171,173,174,175,175,174,175,176,178,180,181,181,181,
+        181,181,183,185,187,188,188,188,187,188,189,192,194,195,195,194,
+        194,194,196,199,201,202,202,201,200,201,203,206,208,209,208,207,
+        206,207,210,213,215,216,215,213,212,213,217,221,223,224,222,219,
+        217,219,224,229,233,232,228,222,219,222,232,245,252,246,222,180
+    },
+    { // 16 harmonics
+        128,101,76,54,35,21,12,8,7,11,16,23,30,36,40,43,
+        44,43,41,38,36,34,32,32,33,36,38,42,45,48,50,52,
+        52,52,51,50,49,48,48,48,50,52,54,57,59,61,63,63,
+        64,63,63,62,62,62,62,63,65,67,69,71,73,74,75,76,
+        76,76,76,75,75,76,76,77,79,81,83,85,86,87,88,89,
+        89,89,89,89,89,89,90,92,93,95,97,98,100,101,101,102,
+        102,102,102,102,102,103,104,105,107,109,110,112,113,114,115,115,
+        115,115,115,115,116,117,118,119,121,123,124,126,127,127,128,128,
+        128,128,128,129,129,130,132,133,135,137,138,139,140,141,141,141,
+        141,141,141,142,143,144,146,147,149,151,152,153,154,154,154,154,
+        154,154,155,155,156,158,159,161,163,164,166,167,167,167,167,167,
+        167,167,168,169,170,171,173,175,177,179,180,180,181,181,180,180,
+        180,180,181,182,183,185,187,189,191,193,194,194,194,194,193,193,
+        192,193,193,195,197,199,202,204,206,208,208,208,207,206,205,204,
+        204,204,206,208,211,214,218,220,223,224,224,222,220,218,215,213,
+        212,213,216,220,226,233,240,245,249,248,244,235,221,202,180,155
+    },
+    { // 8 harmonics
+        128,115,101,88,76,65,54,45,36,29,23,19,16,14,13,13,
+        14,17,19,23,26,30,34,38,42,45,48,51,53,55,56,57,
+        57,57,56,55,54,53,52,51,51,50,50,50,50,50,51,53,
+        54,56,58,60,62,65,67,69,71,73,74,76,77,77,78,78,
+        78,78,78,78,77,77,77,77,77,77,78,78,79,80,82,83,
+        85,86,88,90,92,94,95,97,98,99,100,101,102,102,103,103,
+        103,103,103,103,103,103,103,103,104,104,105,106,108,109,110,112,
+        114,115,117,119,120,122,123,124,125,126,127,127,128,128,128,128,
+        128,128,128,128,128,129,129,130,131,132,133,134,136,137,139,141,
+        142,144,146,147,148,150,151,152,152,153,153,153,153,153,153,153,
+        153,153,153,154,154,155,156,157,158,159,161,162,164,166,168,170,
+        171,173,174,176,177,178,178,179,179,179,179,179,179,178,178,178,
+        178,178,178,179,179,180,182,183,185,187,189,191,194,196,198,200,
+        202,203,205,206,206,206,206,206,205,205,204,203,202,201,200,199,
+        199,199,200,201,203,205,208,211,214,218,222,226,230,233,237,239,
+        242,243,243,242,240,237,233,227,220,211,202,191,180,168,155,141
+    },
+    { // 4 harmonics
+        128,121,115,108,101,95,89,82,77,71,65,60,55,51,47,43,
+        39,36,33,30,28,27,25,24,23,23,23,23,24,25,26,27,
+        29,31,33,35,37,39,42,44,47,49,52,54,57,59,62,64,
+        66,68,70,72,74,75,76,78,79,80,80,81,81,82,82,82,
+        82,82,82,82,82,81,81,81,81,80,80,80,80,80,80,80,
+        80,81,81,82,82,83,84,85,86,87,88,90,91,93,94,96,
+        98,99,101,103,104,106,108,110,111,113,114,116,117,119,120,121,
+        122,123,124,125,125,126,126,127,127,127,128,128,128,128,128,128,
+        128,128,128,128,128,128,128,129,129,129,130,130,131,131,132,133,
+        134,135,136,137,139,140,142,143,145,146,148,150,152,153,155,157,
+        158,160,162,163,165,166,168,169,170,171,172,173,174,174,175,175,
+        176,176,176,176,176,176,176,176,175,175,175,175,174,174,174,174,
+        174,174,174,174,175,175,176,176,177,178,180,181,182,184,186,188,
+        190,192,194,197,199,202,204,207,209,212,214,217,219,221,223,225,
+        227,229,230,231,232,233,233,233,233,232,231,229,228,226,223,220,
+        217,213,209,205,201,196,191,185,179,174,167,161,155,148,141,135
+    },
+    { // 2 harmonics
+        128,125,121,118,115,111,108,105,101,98,95,92,89,86,83,80,
+        77,75,72,69,67,65,62,60,58,56,54,52,51,49,48,46,
+        45,44,43,42,41,40,40,39,39,39,39,39,39,39,39,40,
+        40,41,41,42,43,44,45,46,47,49,50,51,53,54,56,58,
+        59,61,63,64,66,68,70,72,74,76,78,79,81,83,85,87,
+        89,91,92,94,96,98,99,101,103,104,106,107,109,110,111,113,
+        114,115,116,117,118,119,120,121,122,122,123,124,124,125,125,126,
+        126,126,127,127,127,127,127,128,128,128,128,128,128,128,128,128,
+        128,128,128,128,128,128,128,128,128,128,129,129,129,129,129,130,
+        130,130,131,131,132,132,133,134,134,135,136,137,138,139,140,141,
+        142,143,145,146,147,149,150,152,153,155,157,158,160,162,164,165,
+        167,169,171,173,175,177,178,180,182,184,186,188,190,192,193,195,
+        197,198,200,202,203,205,206,207,209,210,211,212,213,214,215,215,
+        216,216,217,217,217,217,217,217,217,217,216,216,215,214,213,212,
+        211,210,208,207,205,204,202,200,198,196,194,191,189,187,184,181,
+        179,176,173,170,167,164,161,158,155,151,148,145,141,138,135,131
+    },
+    { // 1 harmonics
+        128,126,125,123,121,120,118,116,115,113,111,110,108,106,105,103,
+        102,100,99,97,96,94,93,91,90,88,87,86,84,83,82,81,
+        79,78,77,76,75,74,73,72,71,70,69,68,67,67,66,65,
+        64,64,63,63,62,62,61,61,61,60,60,60,60,59,59,59,
+        59,59,59,59,60,60,60,60,61,61,61,62,62,63,63,64,
+        64,65,66,67,67,68,69,70,71,72,73,74,75,76,77,78,
+        79,81,82,83,84,86,87,88,90,91,93,94,96,97,99,100,
+        102,103,105,106,108,110,111,113,115,116,118,120,121,123,125,126,
+        128,130,131,133,135,136,138,140,141,143,145,146,148,150,151,153,
+        154,156,157,159,160,162,163,165,166,168,169,170,172,173,174,175,
+        177,178,179,180,181,182,183,184,185,186,187,188,189,189,190,191,
+        192,192,193,193,194,194,195,195,195,196,196,196,196,197,197,197,
+        197,197,197,197,196,196,196,196,195,195,195,194,194,193,193,192,
+        192,191,190,189,189,188,187,186,185,184,183,182,181,180,179,178,
+        177,175,174,173,172,170,169,168,166,165,163,162,160,159,157,156,
+        154,153,151,150,148,146,145,143,141,140,138,136,135,133,131,130
+    }
+};
+
+const uint8_t SQUARE_TABLES[WAVETABLE_LEVELS][256] PROGMEM = {
+    { // 127 harmonics
+        128,245,217,234,222,231,224,230,224,229,225,229,225,229,226,228,
+        226,228,226,228,226,228,226,228,226,228,226,228,226,228,226,228,
+        226,228,226,228,226,228,226,228,226,228,226,228,226,228,226,228,
+        226,228,226,228,226,228,226,228,226,227,227,227,227,227,227,227,
+        227,227,227,227,227,227,227,227,226,228,226,228,226,228,226,228,
+        226,228,226,228,226,228,226,228,226,228,226,228,226,228,226,228,
+        226,228,226,228,226,228,226,228,226,228,226,228,226,228,226,228,
+        226,228,226,229,225,229,225,229,224,230,224,231,222,234,217,245,
+        128,11,39,22,34,25,32,26,32,27,31,27,31,27,30,28,
+        30,28,30,28,30,28,30,28,30,28,30,28,30,28,30,28,
+        30,28,30,28,30,28,30,28,30,28,30,28,30,28,30,28,
+        30,28,30,28,30,28,30,28,30,29,29,29,29,29,29,29,
+        29,29,29,29,29,29,29,29,30,28,30,28,30,28,30,28,
+        30,28,30,28,30,28,30,28,30,28,30,28,30,28,30,28,
+        30,28,30,28,30,28,30,28,30,28,30,28,30,28,30,28,
+        30,28,30,27,31,27,31,27,32,26,32,25,34,22,39,11
+    },
+    { // 64 harmonics
+        128,214,245,229,217,226,234,227,222,227,231,227,224,227,230,227,
+        224,227,229,227,225,227,229,227,225,227,229,227,225,227,228,227,
+        226,227,228,227,226,227,228,227,226,227,228,227,226,227,228,227,
+        226,227,228,227,226,227,228,227,226,227,228,227,226,227,228,227,
+        226,227,228,227,226,227,228,227,226,227,228,227,226,227,228,227,
+        226,227,228,227,226,227,228,227,226,227,228,227,226,227,228,227,
+        226,227,228,227,225,227,229,227,225,227,229,227,225,227,229,227,
+        224,227,230,227,224,227,231,227,222,227,234,226,217,229,245,214,
+        128,42,11,27,39,30,22,29,34,29,25,29,32,29,26,29,
+        32,29,27,29,31,29,27,29,31,29,27,29,31,29,28,29,
+        30,29,28,29,30,29,28,29,30,29,28,29,30,29,28,29,
+        30,29,28,29,30,29,28,29,30,29,28,29,30,29,28,29,
+        30,29,28,29,30,29,28,29,30,29,28,29,30,29,28,29,
+        30,29,28,29,30,29,28,29,30,29,28,29,30,29,28,29,
+        30,29,28,29,31,29,27,29,31,29,27,29,31,29,27,29,
+        32,29,26,29,32,29,25,29,34,29,22,30,39,27,11,42
+    },
+    { // 32 harmonics
+        128,176,214,238,245,240,229,221,217,220,226,232,234,232,227,223,
+        222,223,227,230,231,230,227,225,223,224,227,229,230,229,227,225,
+        224,225,227,229,230,229,227,225,225,225,227,229,229,229,227,225,
+        225,225,227,228,229,228,227,226,225,226,227,228,229,228,227,226,
+        225,226,227,228,229,228,227,226,225,226,227,228,229,228,227,225,
+        225,225,227,229,229,229,227,225,225,225,227,229,230,229,227,225,
+        224,225,227,229,230,229,227,224,223,225,227,230,231,230,227,223,
+        222,223,227,232,234,232,226,220,217,221,229,240,245,238,214,176,
+        128,80,42,18,11,16,27,35,39,36,30,24,22,24,29,33,
+        34,33,29,26,25,26,29,31,33,32,29,27,26,27,29,31,
+        32,31,29,27,26,27,29,31,31,31,29,27,27,27,29,31,
+        31,31,29,28,27,28,29,30,31,30,29,28,27,28,29,30,
+        31,30,29,28,27,28,29,30,31,30,29,28,27,28,29,31,
+        31,31,29,27,27,27,29,31,31,31,29,27,26,27,29,31,
+        32,31,29,27,26,27,29,32,33,31,29,26,25,26,29,33,
+        34,33,29,24,22,24,30,36,39,35,27,16,11,18,42,80
+    },
+    { // 16 harmonics
+        128,153,176,197,214,228,238,243,245,243,240,235,229,224,220,218,
+        217,218,220,223,226,229,232,233,234,233,232,230,227,225,223,222,
+        221,222,223,225,227,229,230,231,232,231,230,229,227,225,224,223,
+        223,223,224,225,227,228,230,231,231,231,230,229,227,226,224,223,
+        223,223,224,226,227,229,230,231,231,231,230,228,227,225,224,223,
+        223,223,224,225,227,229,230,231,232,231,230,229,227,225,223,222,
+        221,222,223,225,227,230,232,233,234,233,232,229,226,223,220,218,
+        217,218,220,224,229,235,240,243,245,243,238,228,214,197,176,153,
+        128,103,80,59,42,28,18,13,11,13,16,21,27,32,36,38,
+        39,38,36,33,30,27,24,23,22,23,24,26,29,31,33,34,
+        35,34,33,31,29,27,26,25,24,25,26,27,29,31,32,33,
+        33,33,32,31,29,28,26,25,25,25,26,27,29,30,32,33,
+        33,33,32,30,29,27,26,25,25,25,26,28,29,31,32,33,
+        33,33,32,31,29,27,26,25,24,25,26,27,29,31,33,34,
+        35,34,33,31,29,26,24,23,22,23,24,27,30,33,36,38,
+        39,38,36,32,27,21,16,13,11,13,18,28,42,59,80,103
+    },
+    { // 8 harmonics
+        128,140,153,164,176,187,197,206,215,222,228,234,238,241,244,245,
+        245,245,244,242,240,238,235,232,229,226,224,222,220,218,217,217,
+        216,216,217,218,219,221,223,224,226,228,230,231,233,234,235,235,
+        235,235,235,234,233,232,230,229,227,226,224,223,222,221,220,219,
+        219,219,220,221,222,223,224,226,227,229,230,232,233,234,235,235,
+        235,235,235,234,233,231,230,228,226,224,223,221,219,218,217,216,
+        216,217,217,218,220,222,224,226,229,232,235,238,240,242,244,245,
+        245,245,244,241,238,234,228,222,215,206,197,187,176,164,153,140,
+        128,116,103,92,80,69,59,50,41,34,28,22,18,15,12,11,
+        11,11,12,14,16,18,21,24,27,30,32,34,36,38,39,39,
+        40,40,39,38,37,35,33,32,30,28,26,25,23,22,21,21,
+        21,21,21,22,23,24,26,27,29,30,32,33,34,35,36,37,
+        37,37,36,35,34,33,32,30,29,27,26,24,23,22,21,21,
+        21,21,21,22,23,25,26,28,30,32,33,35,37,38,39,40,
+        40,39,39,38,36,34,32,30,27,24,21,18,16,14,12,11,
+        11,11,12,15,18,22,28,34,41,50,59,69,80,92,103,116
+    },
+    { // 4 harmonics
+        128,134,140,146,153,159,164,170,176,181,187,192,197,202,207,211,
+        215,219,223,226,229,232,235,237,239,241,243,244,245,246,246,247,
+        247,247,246,246,245,244,243,242,241,240,238,237,235,233,232,230,
+        228,227,225,223,222,221,219,218,217,216,215,214,213,213,212,212,
+        212,212,212,213,213,214,215,216,217,218,219,221,222,223,225,227,
+        228,230,232,233,235,237,238,240,241,242,243,244,245,246,246,247,
+        247,247,246,246,245,244,243,241,239,237,235,232,229,226,223,219,
+        215,211,207,202,197,192,187,181,176,170,164,159,153,146,140,134,
+        128,122,116,110,103,97,92,86,80,75,69,64,59,54,49,45,
+        41,37,33,30,27,24,21,19,17,15,13,12,11,10,10,9,
+        9,9,10,10,11,12,13,14,15,16,18,19,21,23,24,26,
+        28,29,31,33,34,35,37,38,39,40,41,42,43,43,44,44,
+        44,44,44,43,43,42,41,40,39,38,37,35,34,33,31,29,
+        28,26,24,23,21,19,18,16,15,14,13,12,11,10,10,9,
+        9,9,10,10,11,12,13,15,17,19,21,24,27,30,33,37,
+        41,45,49,54,59,64,69,75,80,86,92,97,103,110,116,122
+    },
+    { // 2 harmonics
+        128,131,134,137,140,143,146,150,153,156,159,162,165,168,170,173,
+        176,179,182,185,187,190,193,195,198,201,203,206,208,210,213,215,
+        217,219,221,223,225,227,229,231,233,234,236,238,239,241,242,243,
+        244,246,247,248,249,249,250,251,252,252,253,253,253,254,254,254,
+        254,254,254,254,253,253,253,252,252,251,250,249,249,248,247,246,
+        244,243,242,241,239,238,236,234,233,231,229,227,225,223,221,219,
+        217,215,213,210,208,206,203,201,198,195,193,190,187,185,182,179,
+        176,173,170,168,165,162,159,156,153,150,146,143,140,137,134,131,
+        128,125,122,119,116,113,110,106,103,100,97,94,91,88,86,83,
+        80,77,74,71,69,66,63,61,58,55,53,50,48,46,43,41,
+        39,37,35,33,31,29,27,25,23,22,20,18,17,15,14,13,
+        12,10,9,8,7,7,6,5,4,4,3,3,3,2,2,2,
+        2,2,2,2,3,3,3,4,4,5,6,7,7,8,9,10,
+        12,13,14,15,17,18,20,22,23,25,27,29,31,33,35,37,
+        39,41,43,46,48,50,53,55,58,61,63,66,69,71,74,77,
+        80,83,86,88,91,94,97,100,103,106,110,113,116,119,122,125
+    },
+    { // 1 harmonics
+        128,131,134,137,140,143,146,150,153,156,159,162,165,168,170,173,
+        176,179,182,185,187,190,193,195,198,201,203,206,208,210,213,215,
+        217,219,221,223,225,227,229,231,233,234,236,238,239,241,242,243,
+        244,246,247,248,249,249,250,251,252,252,253,253,253,254,254,254,
+        254,254,254,254,253,253,253,252,252,251,250,249,249,248,247,246,
+        244,243,242,241,239,238,236,234,233,231,229,227,225,223,221,219,
+        217,215,213,210,208,206,203,201,198,195,193,190,187,185,182,179,
+        176,173,170,168,165,162,159,156,153,150,146,143,140,137,134,131,
+        128,125,122,119,116,113,110,106,103,100,97,94,91,88,86,83,
+        80,77,74,71,69,66,63,61,58,55,53,50,48,46,43,41,
+        39,37,35,33,31,29,27,25,23,22,20,18,17,15,14,13,
+        12,10,9,8,7,7,6,5,4,4,3,3,3,2,2,2,
+        2,2,2,2,3,3,3,4,4,5,6,7,7,8,9,10,
+        12,13,14,15,17,18,20,22,23,25,27,29,31,33,35,37,
+        39,41,43,46,48,50,53,55,58,61,63,66,69,71,74,77,
+        80,83,86,88,91,94,97,100,103,106,110,113,116,119,122,125
+    }
+};
+
+} // namespace Synth
+
+#endif // WAVETABLES_H
@@ -0,0 +1,167 @@
+#ifndef PID_H
+#define PID_H
+
+#include <Arduino.h>
+
+namespace Thermal {
+
+// Fixed-point PID controller for heaters
+//
+// Temperatures are int32_t in centi-degrees Celsius (2500 = 25.00 C).
+// Output is a 16-bit duty cycle (0 = off, 65535 = fully on), ready for
+// HeaterOutputISR::setDuty().
+//
+// Gains are given in floats at setup time and converted once to fixed point,
+// so update() only does integer multiplies and adds:
+//   kp: output fraction per degree C of error        (0.05 = 5% per C)
+//   ki: output fraction per degree C per second      (integral)
+//   kd: output fraction per degree C/s of input rate (derivative)
+//
+// The derivative acts on the measurement rather than the error, so setpoint
+// changes do not kick the output. The integral is clamped to the output
+// limits (anti-windup) and stored pre-multiplied by ki, so gains can be
+// changed on the fly without a bump.
+//
+// Usage:
+//   PID pid(250);                      // update() called every 250 ms
+//   pid.setTunings(0.05f, 0.002f, 0.2f);
+//   pid.setSetpoint(4000);             // 40.00 C
+//   uint16_t duty = pid.update(measuredCentiC);
+
+class PID {
+public:
+    static const uint16_t OUTPUT_MAX = 65535;
+
+    PID(uint16_t periodMs = 250)
+        : _periodMs(periodMs)
+        , _kp(0.0f)
+        , _ki(0.0f)
+        , _kd(0.0f)
+        , _setpoint(0)
+        , _outMin(0)
+        , _outMax(OUTPUT_MAX)
+        , _integral(0)
+        , _lastInput(0)
+        , _output(0)
+        , _primed(false)
+    {
+        setTunings(_kp, _ki, _kd);
+    }
+
+    // Set gains (see units above). Negative gains are treated as zero.
+    void setTunings(float kp, float ki, float kd) {
+        _kp = kp > 0.0f ? kp : 0.0f;
+        _ki = ki > 0.0f ? ki : 0.0f;
+        _kd = kd > 0.0f ? kd : 0.0f;
+        calculateGains();
+    }
+
+    // Set the interval between update() calls in milliseconds
+    void setPeriod(uint16_t ms) {
+        if (ms == 0) return;
+        _periodMs = ms;
+        calculateGains();
+    }
+
+    void setSetpoint(int32_t centiC) {
+        _setpoint = centiC;
+    }
+
+    void setOutputLimits(uint16_t outMin, uint16_t outMax) {
+        if (outMin >= outMax) return;
+        _outMin = outMin;
+        _outMax = outMax;
+        _integral = constrain(_integral, (int32_t)_outMin << SHIFT, (int32_t)_outMax << SHIFT);
+        _output = constrain(_output, _outMin, _outMax);
+    }
+
+    // Run one control step with the latest measurement, returns duty (0-65535)
+    uint16_t update(int32_t input) {
+        if (!_primed) {
+            _lastInput = input;
+            _primed = true;
+        }
+
+        int32_t error = _setpoint - input;
+
+        _integral += scale(error, _kiFixed, _kiLimit);
+        _integral = constrain(_integral, (int32_t)_outMin << SHIFT, (int32_t)_outMax << SHIFT);
+
+        int32_t sum = scale(error, _kpFixed, _kpLimit)
+                    + _integral
+                    - scale(input - _lastInput, _kdFixed, _kdLimit);
+        _lastInput = input;
+
+        sum >>= SHIFT;
+        _output = (uint16_t)constrain(sum, (int32_t)_outMin, (int32_t)_outMax);
+        return _output;
+    }
+
+    // Restart from a known state without an output bump, e.g. when handing
+    // over from manual or bang-bang control
+    void reset(int32_t input, uint16_t output) {
+        _lastInput = input;
+        _primed = true;
+        _output = constrain(output, _outMin, _outMax);
+        _integral = (int32_t)_output << SHIFT;
+    }
+
+    int32_t getSetpoint() const { return _setpoint; }
+    uint16_t getOutput() const { return _output; }
+    uint16_t getPeriod() const { return _periodMs; }
+    float getKp() const { return _kp; }
+    float getKi() const { return _ki; }
+    float getKd() const { return _kd; }
+
+private:
+    // Fixed-point terms carry SHIFT extra fraction bits below the output LSB
+    static const uint8_t SHIFT = 6;
+    // Any single term beyond this already saturates the output
+    static const int32_t TERM_MAX = (int32_t)OUTPUT_MAX << (SHIFT + 1);
+
+    // gain * value with value clamped so the product stays within TERM_MAX
+    static int32_t scale(int32_t value, int32_t gain, int32_t limit) {
+        return constrain(value, -limit, limit) * gain;
+    }
+
+    static int32_t toFixed(float gainPerC) {
+        // Output full scale (65536) per degree C -> per centi-degree, plus SHIFT
+        return (int32_t)(gainPerC * (65536.0f / 100.0f) * (1 << SHIFT) + 0.5f);
+    }
+
+    static int32_t limitFor(int32_t gain) {
+        return gain > 0 ? TERM_MAX / gain + 1 : TERM_MAX;
+    }
+
+    void calculateGains() {
+        float dt = _periodMs / 1000.0f;
+        _kpFixed = toFixed(_kp);
+        _kiFixed = toFixed(_ki * dt);
+        _kdFixed = toFixed(_kd / dt);
+        _kpLimit = limitFor(_kpFixed);
+        _kiLimit = limitFor(_kiFixed);
+        _kdLimit = limitFor(_kdFixed);
+    }
+
+    uint16_t _periodMs;
+    float _kp;
+    float _ki;
+    float _kd;
+    int32_t _kpFixed;     // Per-step gains, Q(SHIFT) output per centi-degree
+    int32_t _kiFixed;
+    int32_t _kdFixed;
+    int32_t _kpLimit;     // Input clamp keeping each product in range
+    int32_t _kiLimit;
+    int32_t _kdLimit;
+    int32_t _setpoint;
+    uint16_t _outMin;
+    uint16_t _outMax;
+    int32_t _integral;    // ki-weighted error sum, Q(SHIFT) output units
+    int32_t _lastInput;
+    uint16_t _output;
+    bool _primed;
+};
+
+} // namespace Thermal
+
+#endif // PID_H
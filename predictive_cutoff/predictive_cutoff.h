@@ -0,0 +1,80 @@
+#ifndef PREDICTIVE_CUTOFF_H
+#define PREDICTIVE_CUTOFF_H
+
+#include <Arduino.h>
+#include "rate_estimator.h"
+
+namespace Thermal {
+
+// Thermal-lag-aware heater cutoff
+//
+// After a heater is switched off the measured temperature keeps rising for
+// about the zone's dead time, because heat already in the element still has
+// to reach the sensor. Switching off when the reading hits the target
+// therefore overshoots by roughly rate * deadTime.
+//
+// PredictiveCutoff tracks the heating rate with a sliding-window
+// least-squares fit and stops heating as soon as the predicted peak
+//   fittedTemperature + rate * deadTime + margin
+// reaches the target. The dead time comes from the identified heater model
+// (ThermalModel::deadTime, see autotune.h).
+//
+// Usage:
+//   PredictiveCutoff<16> cutoff(12000);        // 12 s dead time
+//   cutoff.add(millis(), temperatureCentiC);
+//   if (cutoff.shouldStopHeating(4000)) {      // 40.00 C target
+//       heater.setDuty(ch, 0);
+//   }
+
+template <uint8_t N>
+class PredictiveCutoff {
+public:
+    PredictiveCutoff(uint32_t deadTimeMs = 0)
+        : _deadTimeMs(deadTimeMs)
+        , _margin(0)
+    {}
+
+    // Time between a heater change and its first effect on the sensor
+    void setDeadTime(uint32_t ms) { _deadTimeMs = ms; }
+
+    // Extra safety margin below the target, in centi-degrees
+    void setMargin(int32_t centiC) { _margin = centiC; }
+
+    void add(uint32_t timeMs, int32_t temperature) {
+        _rate.add(timeMs, temperature);
+    }
+
+    void reset() { _rate.reset(); }
+
+    // Temperature the zone is expected to coast to if heating stops now
+    int32_t predictedPeak() const {
+        int32_t rise = _rate.change(_deadTimeMs);
+        return _rate.fittedValue() + (rise > 0 ? rise : 0);
+    }
+
+    // True when heating must stop to land on the target. Until the window
+    // holds enough samples to fit a rate only the raw reading is used.
+    bool shouldStopHeating(int32_t target) const {
+        if (!_rate.isValid()) {
+            return _rate.getCount() > 0 && _rate.latestValue() + _margin >= target;
+        }
+        return predictedPeak() + _margin >= target;
+    }
+
+    // Current heating rate over intervalMs (e.g. 1000 for per second)
+    int32_t rate(uint32_t intervalMs = 1000) const {
+        return _rate.change(intervalMs);
+    }
+
+    uint32_t getDeadTime() const { return _deadTimeMs; }
+    const SlopeEstimator<N>& getEstimator() const { return _rate; }
+
+private:
+    SlopeEstimator<N> _rate;
+    uint32_t _deadTimeMs;
+    int32_t _margin;
+};
+
+} // namespace Thermal
+
+#endif // PREDICTIVE_CUTOFF_H
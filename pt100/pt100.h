@@ -0,0 +1,73 @@
+#ifndef PT100_H
+#define PT100_H
+
+#include <Arduino.h>
+
+namespace Thermal {
+
+// E3D PT100 amplifier transfer curve
+// Output voltage to temperature by piecewise-linear interpolation,
+// taken from https://wiki.e3d-online.com/E3D_PT100_Amplifier_Documentation
+//
+// Tables are stored in PROGMEM as integers (degrees C and millivolts) and
+// interpolated in fixed point, results are in centi-degrees C.
+//
+// Usage:
+//   int32_t temperature;
+//   if (pt100AdcToCentiC(analogRead(A13), 5000, temperature)) {
+//       // temperature = 2150 means 21.50 C
+//   }
+
+const uint8_t PT100_NUM_POINTS = 49;
+
+const int16_t PT100_TEMPERATURES[PT100_NUM_POINTS] PROGMEM = {
+    0, 1, 10, 20, 30, 40, 50, 60, 70, 80, 90, 100, 110, 120, 130, 140, 150,
+    160, 170, 180, 190, 200, 210, 220, 230, 240, 250, 260, 270, 280, 290, 300,
+    310, 320, 330, 340, 350, 360, 370, 380, 390, 400, 500, 600, 700, 800, 900,
+    1000, 1100
+};
+
+const uint16_t PT100_MILLIVOLTS[PT100_NUM_POINTS] PROGMEM = {
+    0, 1110, 1150, 1200, 1240, 1280, 1320, 1360, 1400, 1440, 1480, 1520, 1560,
+    1610, 1650, 1680, 1720, 1760, 1800, 1840, 1880, 1920, 1960, 2000, 2040,
+    2070, 2110, 2150, 2180, 2220, 2260, 2290, 2330, 2370, 2410, 2440, 2480,
+    2510, 2550, 2580, 2620, 2660, 3000, 3330, 3630, 3930, 4210, 4480, 4730
+};
+
+// Convert amplifier output voltage to temperature.
+// Returns false if the voltage is outside the table.
+inline bool pt100MillivoltsToCentiC(uint16_t mv, int32_t& centiC) {
+    uint16_t vFirst = pgm_read_word(&PT100_MILLIVOLTS[0]);
+    uint16_t vLast = pgm_read_word(&PT100_MILLIVOLTS[PT100_NUM_POINTS - 1]);
+    if (mv < vFirst || mv > vLast) return false;
+
+    // Binary search for the interval containing mv
+    uint8_t lo = 0;
+    uint8_t hi = PT100_NUM_POINTS - 1;
+    while (hi - lo > 1) {
+        uint8_t mid = (lo + hi) >> 1;
+        if (mv > pgm_read_word(&PT100_MILLIVOLTS[mid])) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    int32_t t0 = (int16_t)pgm_read_word(&PT100_TEMPERATURES[lo]);
+    int32_t t1 = (int16_t)pgm_read_word(&PT100_TEMPERATURES[hi]);
+    uint16_t v0 = pgm_read_word(&PT100_MILLIVOLTS[lo]);
+    uint16_t v1 = pgm_read_word(&PT100_MILLIVOLTS[hi]);
+
+    centiC = t0 * 100 + ((t1 - t0) * 100 * (int32_t)(mv - v0)) / (int32_t)(v1 - v0);
+    return true;
+}
+
+// Convert a 10-bit ADC reading of the amplifier output to temperature
+inline bool pt100AdcToCentiC(uint16_t adc, uint16_t vrefMv, int32_t& centiC) {
+    uint16_t mv = ((uint32_t)adc * vrefMv + 511) / 1023;
+    return pt100MillivoltsToCentiC(mv, centiC);
+}
+
+} // namespace Thermal
+
+#endif // PT100_H
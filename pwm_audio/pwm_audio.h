@@ -3,10 +3,16 @@
 
 #include <Arduino.h>
 
+#define TIMER_USES_AUDIO_PWM
+#define TIMER_USES_AUDIO_SAMPLE
+#include "timer_alloc.h"
+
 namespace Synth {
 
 // PWM Audio Output for Arduino
-// Uses Timer1 or Timer2 for high-frequency PWM suitable for audio
+// Uses TIMER_AUDIO_PWM (see timer_alloc.h) for high-frequency PWM suitable
+// for audio: Timer3 on the Mega (pins 5 and 2), Timer2 on the Uno (pins 11
+// and 3). Any 8 or 16-bit timer can be assigned with a build flag.
 //
 // PWM frequency should be well above audio range (>20kHz)
 // to allow filtering with a simple RC low-pass filter
@@ -16,39 +22,55 @@ namespace Synth {
 //                                      |
 //                                     GND
 //
+// 16-bit output uses both pins of the timer (dual PWM): the high byte on
+// OUTPUT_A, the low byte on OUTPUT_B, mixed 256:1 by the resistors:
+//   OUTPUT_A -> 3.9k resistor --+
+//   OUTPUT_B -> 1M resistor ----+--> Audio output
+//                               |
+//                          10nF capacitor
+//                               |
+//                              GND
+//
 // Usage:
 //   PWMAudio audio;
-//   audio.begin(PWMAudio::TIMER1_PIN_9);  // Use pin 9
+//   audio.begin(PWMAudio::OUTPUT_A);  // OCnA pin of TIMER_AUDIO_PWM
 //   audio.setSampleRate(22050);
 //   audio.write(sample);  // Write 8-bit sample
+//
+//   audio.beginDual();
+//   audio.write16(osc.nextSample16());  // Write 16-bit sample
 
 class PWMAudio {
 public:
-    // Available PWM pins by timer
+    // Output compare pins of the audio PWM timer
     enum OutputPin {
-        TIMER1_PIN_9  = 9,   // OC1A - 16-bit timer
-        TIMER1_PIN_10 = 10,  // OC1B - 16-bit timer
-        TIMER2_PIN_3  = 3,   // OC2B - 8-bit timer
-        TIMER2_PIN_11 = 11   // OC2A - 8-bit timer
+        OUTPUT_A = TIMER_PIN(TIMER_AUDIO_PWM, A),
+        OUTPUT_B = TIMER_PIN(TIMER_AUDIO_PWM, B)
     };
 
     PWMAudio()
-        : _pin(TIMER2_PIN_11)
+        : _pin(OUTPUT_A)
         , _sampleRate(22050)
+        , _dual(false)
         , _initialized(false)
     {}
 
     // Initialize PWM audio output
-    void begin(OutputPin pin = TIMER2_PIN_11) {
+    void begin(OutputPin pin = OUTPUT_A) {
         _pin = pin;
+        _dual = false;
         pinMode(_pin, OUTPUT);
+        setupTimer();
+        _initialized = true;
+    }
 
-        if (_pin == TIMER1_PIN_9 || _pin == TIMER1_PIN_10) {
-            setupTimer1();
-        } else {
-            setupTimer2();
-        }
-
+    // Initialize 16-bit dual PWM output on both pins
+    void beginDual() {
+        _pin = OUTPUT_A;
+        _dual = true;
+        pinMode(OUTPUT_A, OUTPUT);
+        pinMode(OUTPUT_B, OUTPUT);
+        setupTimer();
         _initialized = true;
     }
 
@@ -56,30 +78,23 @@ public:
     void write(uint8_t sample) {
         if (!_initialized) return;
 
-        switch (_pin) {
-            case TIMER1_PIN_9:
-                OCR1A = sample;
-                break;
-            case TIMER1_PIN_10:
-                OCR1B = sample;
-                break;
-            case TIMER2_PIN_3:
-                OCR2B = sample;
-                break;
-            case TIMER2_PIN_11:
-                OCR2A = sample;
-                break;
+        if (_pin == OUTPUT_A) {
+            TIMER_REG(OCR, TIMER_AUDIO_PWM, A) = sample;
+        } else {
+            TIMER_REG(OCR, TIMER_AUDIO_PWM, B) = sample;
         }
     }
 
-    // Write 16-bit sample (only for Timer1 pins)
+    // Write 16-bit sample: full resolution after beginDual(), otherwise
+    // the high byte goes to the single pin
     void write16(uint16_t sample) {
         if (!_initialized) return;
 
-        if (_pin == TIMER1_PIN_9) {
-            OCR1A = sample;
-        } else if (_pin == TIMER1_PIN_10) {
-            OCR1B = sample;
+        if (_dual) {
+            TIMER_REG(OCR, TIMER_AUDIO_PWM, A) = sample >> 8;
+            TIMER_REG(OCR, TIMER_AUDIO_PWM, B) = sample & 0xFF;
+        } else {
+            write(sample >> 8);
         }
     }
 
@@ -97,78 +112,57 @@ public:
     }
 
     void end() {
-        if (_pin == TIMER1_PIN_9 || _pin == TIMER1_PIN_10) {
-            TCCR1A = 0;
-            TCCR1B = 0;
-        } else {
-            TCCR2A = 0;
-            TCCR2B = 0;
-        }
+        TIMER_REG(TCCR, TIMER_AUDIO_PWM, A) = 0;
+        TIMER_REG(TCCR, TIMER_AUDIO_PWM, B) = 0;
         _initialized = false;
     }
 
 private:
-    void setupTimer1() {
-        // Timer1: Fast PWM, 8-bit mode
+    void setupTimer() {
+        // Fast PWM, 8-bit, no prescaler
         // PWM frequency = 16MHz / 256 = 62.5 kHz
+        uint8_t oldSREG = SREG;
         cli();
 
-        TCCR1A = 0;
-        TCCR1B = 0;
-
-        // Fast PWM, 8-bit (TOP = 0x00FF)
-        TCCR1A |= (1 << WGM10);
-        TCCR1B |= (1 << WGM12);
-
-        // No prescaler (CS10 = 1)
-        TCCR1B |= (1 << CS10);
-
-        if (_pin == TIMER1_PIN_9) {
-            // Non-inverting mode on OC1A
-            TCCR1A |= (1 << COM1A1);
-            OCR1A = 128; // 50% duty cycle initially
+#if TIMER_IS_16BIT(TIMER_AUDIO_PWM)
+        // Fast PWM, 8-bit (WGMn2:0 = 101, TOP = 0x00FF)
+        uint8_t controlA = (1 << WGM10);
+        TIMER_REG(TCCR, TIMER_AUDIO_PWM, B) = (1 << WGM12) | (1 << CS10);
+        uint8_t outputA = (1 << COM1A1);
+        uint8_t outputB = (1 << COM1B1);
+#else
+        // Fast PWM (WGM21:20 = 11, TOP = 0xFF)
+        uint8_t controlA = (1 << WGM21) | (1 << WGM20);
+        TIMER_REG(TCCR, TIMER_AUDIO_PWM, B) = (1 << CS20);
+        uint8_t outputA = (1 << COM2A1);
+        uint8_t outputB = (1 << COM2B1);
+#endif
+
+        // Non-inverting mode on the selected pin(s), 50% duty cycle initially
+        if (_dual) {
+            TIMER_REG(TCCR, TIMER_AUDIO_PWM, A) = controlA | outputA | outputB;
+            TIMER_REG(OCR, TIMER_AUDIO_PWM, A) = 128;
+            TIMER_REG(OCR, TIMER_AUDIO_PWM, B) = 0;
+        } else if (_pin == OUTPUT_A) {
+            TIMER_REG(TCCR, TIMER_AUDIO_PWM, A) = controlA | outputA;
+            TIMER_REG(OCR, TIMER_AUDIO_PWM, A) = 128;
         } else {
-            // Non-inverting mode on OC1B
-            TCCR1A |= (1 << COM1B1);
-            OCR1B = 128;
+            TIMER_REG(TCCR, TIMER_AUDIO_PWM, A) = controlA | outputB;
+            TIMER_REG(OCR, TIMER_AUDIO_PWM, B) = 128;
         }
 
-        sei();
-    }
-
-    void setupTimer2() {
-        // Timer2: Fast PWM mode
-        // PWM frequency = 16MHz / 256 = 62.5 kHz
-        cli();
-
-        TCCR2A = 0;
-        TCCR2B = 0;
-
-        // Fast PWM mode (WGM21:20 = 11)
-        TCCR2A |= (1 << WGM21) | (1 << WGM20);
-
-        // No prescaler (CS20 = 1)
-        TCCR2B |= (1 << CS20);
-
-        if (_pin == TIMER2_PIN_11) {
-            // Non-inverting mode on OC2A
-            TCCR2A |= (1 << COM2A1);
-            OCR2A = 128;
-        } else {
-            // Non-inverting mode on OC2B
-            TCCR2A |= (1 << COM2B1);
-            OCR2B = 128;
-        }
-
-        sei();
+        SREG = oldSREG;
     }
 
     OutputPin _pin;
     uint32_t _sampleRate;
+    bool _dual;
     bool _initialized;
 };
 
-// Interrupt-driven audio output using Timer1
+// Interrupt-driven audio output
+// TIMER_AUDIO_SAMPLE interrupts at the sample rate and the callback's
+// sample goes to the OCnA pin of TIMER_AUDIO_PWM.
 // More consistent timing than polling
 class PWMAudioISR {
 public:
@@ -183,53 +177,49 @@ public:
         _callback = callback;
         _sampleRate = sampleRate;
 
-        pinMode(11, OUTPUT);
+        _output.begin(PWMAudio::OUTPUT_A);
 
         cli();
 
-        // Setup Timer2 for PWM output on pin 11
-        TCCR2A = (1 << COM2A1) | (1 << WGM21) | (1 << WGM20);
-        TCCR2B = (1 << CS20);
-        OCR2A = 128;
-
-        // Setup Timer1 for sample rate interrupt
-        TCCR1A = 0;
-        TCCR1B = (1 << WGM12) | (1 << CS10); // CTC mode, no prescaler
+        // Sample rate interrupt: CTC mode, no prescaler
+        TIMER_REG(TCCR, TIMER_AUDIO_SAMPLE, A) = 0;
+        TIMER_REG(TCCR, TIMER_AUDIO_SAMPLE, B) = (1 << WGM12) | (1 << CS10);
 
         // Calculate compare value for desired sample rate
         // Compare match = (16MHz / sampleRate) - 1
-        OCR1A = (16000000UL / sampleRate) - 1;
+        TIMER_REG(OCR, TIMER_AUDIO_SAMPLE, A) = (F_CPU / sampleRate) - 1;
 
-        // Enable Timer1 compare match interrupt
-        TIMSK1 |= (1 << OCIE1A);
+        // Enable compare match interrupt
+        TIMER_REG(TIMSK, TIMER_AUDIO_SAMPLE, ) |= (1 << OCIE1A);
 
         sei();
     }
 
     void end() {
-        TIMSK1 &= ~(1 << OCIE1A);
+        TIMER_REG(TIMSK, TIMER_AUDIO_SAMPLE, ) &= ~(1 << OCIE1A);
         _callback = nullptr;
     }
 
     // Called from ISR - do not call directly
     void handleInterrupt() {
         if (_callback) {
-            OCR2A = _callback();
+            TIMER_REG(OCR, TIMER_AUDIO_PWM, A) = _callback();
         }
     }
 
 private:
     PWMAudioISR() : _callback(nullptr), _sampleRate(22050) {}
+    PWMAudio _output;
     SampleCallback _callback;
     uint32_t _sampleRate;
 };
 
 } // namespace Synth
 
-// Timer1 compare match ISR - must be in global scope
+// Sample timer compare match ISR - must be in global scope
 // Uncomment this in your main sketch if using PWMAudioISR:
 /*
-ISR(TIMER1_COMPA_vect) {
+ISR(TIMER_AUDIO_SAMPLE_COMPA_vect) {
     Synth::PWMAudioISR::instance().handleInterrupt();
 }
 */
@@ -0,0 +1,161 @@
+#ifndef RATE_ESTIMATOR_H
+#define RATE_ESTIMATOR_H
+
+#include <Arduino.h>
+
+namespace Thermal {
+
+// Sliding-window least-squares slope estimator
+//
+// Fits a straight line through the last N timestamped samples and reports
+// its slope. Unlike a single difference between two readings, every sample
+// in the window contributes, so sensor noise is averaged out while the
+// estimate still follows ramps without lag in the slope itself.
+//
+// The running sums (n, St, Stt, Sy, Sty) are updated in O(1) per sample:
+// the evicted sample is subtracted and the time origin is moved to the
+// oldest sample in the window. All sums are exact 64-bit integers, so
+// nothing drifts however long the estimator runs.
+//
+// Values are whatever fixed-point unit the caller uses (centi-degrees C
+// for temperatures), timestamps are milliseconds (millis()).
+//
+// Usage:
+//   SlopeEstimator<16> rate;
+//   rate.add(millis(), temperatureCentiC);
+//   int32_t perSecond = rate.change(1000);   // centi-degrees C per second
+//   int32_t now = rate.fittedValue();         // de-noised current value
+
+template <uint8_t N>
+class SlopeEstimator {
+public:
+    SlopeEstimator() {
+        reset();
+    }
+
+    void reset() {
+        _count = 0;
+        _head = 0;
+        _origin = 0;
+        _sumT = 0;
+        _sumTT = 0;
+        _sumY = 0;
+        _sumTY = 0;
+    }
+
+    void add(uint32_t timeMs, int32_t value) {
+        if (_count == 0) {
+            _origin = timeMs;
+        }
+
+        if (_count == N) {
+            // Drop the oldest sample
+            int64_t t = (int64_t)(_times[_head] - _origin);
+            int64_t y = _values[_head];
+            _sumT -= t;
+            _sumTT -= t * t;
+            _sumY -= y;
+            _sumTY -= t * y;
+            _count--;
+        }
+
+        _times[_head] = timeMs;
+        _values[_head] = value;
+        _head = (_head + 1) % N;
+        _count++;
+
+        int64_t t = (int64_t)(timeMs - _origin);
+        int64_t y = value;
+        _sumT += t;
+        _sumTT += t * t;
+        _sumY += y;
+        _sumTY += t * y;
+
+        // Move the origin to the oldest sample so the sums stay small
+        uint32_t oldest = _times[oldestIndex()];
+        int64_t c = (int64_t)(oldest - _origin);
+        if (c != 0) {
+            _sumTY -= c * _sumY;
+            _sumTT -= 2 * c * _sumT - (int64_t)_count * c * c;
+            _sumT -= (int64_t)_count * c;
+            _origin = oldest;
+        }
+    }
+
+    // True once there are enough samples spread over time to fit a line
+    bool isValid() const {
+        return _count >= 2 && denominator() > 0;
+    }
+
+    // Fitted change in value over intervalMs (slope * intervalMs)
+    int32_t change(uint32_t intervalMs) const {
+        if (!isValid()) return 0;
+        return (int32_t)slopeTimes(intervalMs);
+    }
+
+    // Value of the fitted line at the newest sample
+    int32_t fittedValue() const {
+        if (_count == 0) return 0;
+        if (!isValid()) return latestValue();
+        // The line passes through the means: y = mean(y) + slope * (t - mean(t))
+        int64_t newest = (int64_t)(latestTime() - _origin);
+        return (int32_t)((_sumY + slopeTimes(newest * _count - _sumT)) / _count);
+    }
+
+    uint32_t latestTime() const { return _times[(_head + N - 1) % N]; }
+    int32_t latestValue() const { return _values[(_head + N - 1) % N]; }
+
+    // Time spanned by the samples in the window
+    uint32_t span() const {
+        return _count > 0 ? latestTime() - _times[oldestIndex()] : 0;
+    }
+
+    uint8_t getCount() const { return _count; }
+
+private:
+    uint8_t oldestIndex() const {
+        return (_head + N - _count) % N;
+    }
+
+    int64_t denominator() const {
+        return (int64_t)_count * _sumTT - _sumT * _sumT;
+    }
+
+    static int64_t abs64(int64_t x) {
+        return x < 0 ? -x : x;
+    }
+
+    // slope * dt for a signed dt in ms, multiplying first for precision
+    // unless that would overflow. Then the whole part of the slope is
+    // multiplied on its own and the remainder (smaller than den) is scaled
+    // down with den until it fits, so slopes below 1 unit/ms are kept.
+    int64_t slopeTimes(int64_t dt) const {
+        int64_t den = denominator();
+        int64_t num = (int64_t)_count * _sumTY - _sumT * _sumY;
+        int64_t limit = INT64_MAX / (abs64(dt) + 1);
+        if (abs64(num) < limit) {
+            return num * dt / den;
+        }
+        int64_t whole = num / den * dt;
+        int64_t remainder = num % den;
+        while (abs64(remainder) >= limit) {
+            remainder /= 2;
+            den /= 2;
+        }
+        return whole + remainder * dt / den;
+    }
+
+    uint32_t _times[N];
+    int32_t _values[N];
+    uint8_t _count;
+    uint8_t _head;
+    uint32_t _origin;
+    int64_t _sumT;
+    int64_t _sumTT;
+    int64_t _sumY;
+    int64_t _sumTY;
+};
+
+} // namespace Thermal
+
+#endif // RATE_ESTIMATOR_H
@@ -0,0 +1,257 @@
+#ifndef ROLLING_STATS_H
+#define ROLLING_STATS_H
+
+#include <Arduino.h>
+
+namespace Thermal {
+
+// Sliding-window statistics and alarms for fixed-point sensor streams
+//
+// RollingStats<N, T> keeps the last N samples and reports min, max, mean
+// and variance of the window in O(1) per sample:
+// - min and max come from monotonic deques of ring positions: a new sample
+//   removes every older entry it dominates, so the front of each deque is
+//   always the extreme of the window (amortised O(1))
+// - mean and variance come from exact 64-bit running sums of x and x^2, so
+//   nothing drifts when samples leave the window
+//
+// T is the sample type: int16_t halves the RAM for readings that fit (e.g.
+// centi-degrees C up to 327.67 C), int32_t covers everything else.
+// Samples saturate to the range of T, and int32_t samples to +-2^23
+// (+-83886.07 C in centi-degrees), which keeps N * sum(x^2) and sum(x)^2
+// below 2^63 for any N up to 255.
+// RAM is N * (sizeof(T) + 2) + ~24 bytes, e.g. 216 bytes for <32, int32_t>.
+//
+// ChannelMonitor adds threshold alarms with hysteresis and a smoothed
+// rate-of-change alarm on top of the statistics.
+//
+// Usage:
+//   ChannelMonitor<32, int16_t> object;
+//   object.setThresholds(1000, 8000, 50);          // 10-80 C, 0.5 C hysteresis
+//   object.setRateLimit(200);                       // 2 C/s
+//   object.add(millis(), (int32_t)(mlx.readObjectTempC() * 100));
+//   int32_t mean = object.getStats().getMean();
+//   if (object.alarmsChanged()) report(object.getAlarms());
+
+template <uint8_t N, typename T = int32_t>
+class RollingStats {
+    static_assert(N >= 1, "Window must hold at least one sample");
+    static_assert(sizeof(T) == 2 || sizeof(T) == 4, "Samples are int16_t or int32_t");
+
+public:
+    // Largest sample magnitude, see above
+    static const int32_t LIMIT = sizeof(T) == 2 ? 32767L : 8388607L;
+
+    RollingStats() {
+        reset();
+    }
+
+    void reset() {
+        _count = 0;
+        _head = 0;
+        _sum = 0;
+        _sumSquares = 0;
+        _minFront = _minSize = 0;
+        _maxFront = _maxSize = 0;
+    }
+
+    void add(int32_t value) {
+        if (value > LIMIT) value = LIMIT;
+        if (value < -LIMIT) value = -LIMIT;
+
+        if (_count == N) {
+            // The slot at _head is the oldest sample and is about to go
+            int64_t old = _values[_head];
+            _sum -= old;
+            _sumSquares -= old * old;
+            if (_minSize > 0 && _min[_minFront] == _head) popFront(_minFront, _minSize);
+            if (_maxSize > 0 && _max[_maxFront] == _head) popFront(_maxFront, _maxSize);
+        } else {
+            _count++;
+        }
+
+        _values[_head] = (T)value;
+        _sum += value;
+        _sumSquares += (int64_t)value * value;
+
+        // Drop entries the new sample makes irrelevant, then append it
+        while (_minSize > 0 && _values[back(_min, _minFront, _minSize)] >= value) _minSize--;
+        pushBack(_min, _minFront, _minSize, _head);
+        while (_maxSize > 0 && _values[back(_max, _maxFront, _maxSize)] <= value) _maxSize--;
+        pushBack(_max, _maxFront, _maxSize, _head);
+
+        _head = (_head + 1) % N;
+    }
+
+    uint8_t getCount() const { return _count; }
+    bool isFull() const { return _count == N; }
+
+    T getLatest() const { return _values[(_head + N - 1) % N]; }
+    T getOldest() const { return _values[(_head + N - _count) % N]; }
+    T getMin() const { return _count ? _values[_min[_minFront]] : 0; }
+    T getMax() const { return _count ? _values[_max[_maxFront]] : 0; }
+
+    int32_t getMean() const {
+        if (_count == 0) return 0;
+        // Round to nearest
+        int64_t half = _sum >= 0 ? _count / 2 : -(_count / 2);
+        return (_sum + half) / _count;
+    }
+
+    // Population variance in value units squared, saturated to 32 bits
+    uint32_t getVariance() const {
+        uint64_t variance = variance64();
+        return variance > 0xFFFFFFFFULL ? 0xFFFFFFFFUL : (uint32_t)variance;
+    }
+
+    // Population standard deviation in value units
+    uint32_t getStddev() const {
+        return isqrt(variance64());
+    }
+
+private:
+    uint64_t variance64() const {
+        if (_count < 2) return 0;
+        int64_t spread = (int64_t)_count * _sumSquares - _sum * _sum;
+        return spread > 0 ? (uint64_t)spread / ((uint32_t)_count * _count) : 0;
+    }
+
+    static uint32_t isqrt(uint64_t x) {
+        uint64_t result = 0;
+        uint64_t bit = 1ULL << 62;
+        while (bit > x) bit >>= 2;
+        while (bit != 0) {
+            if (x >= result + bit) {
+                x -= result + bit;
+                result = (result >> 1) + bit;
+            } else {
+                result >>= 1;
+            }
+            bit >>= 2;
+        }
+        return result;
+    }
+
+    // Deques are rings of N ring positions: front index plus size
+    static uint8_t back(const uint8_t* deque, uint8_t front, uint8_t size) {
+        return deque[(front + size - 1) % N];
+    }
+
+    static void pushBack(uint8_t* deque, uint8_t front, uint8_t& size, uint8_t position) {
+        deque[(front + size) % N] = position;
+        size++;
+    }
+
+    static void popFront(uint8_t& front, uint8_t& size) {
+        front = (front + 1) % N;
+        size--;
+    }
+
+    T _values[N];
+    uint8_t _min[N];
+    uint8_t _max[N];
+    uint8_t _count;
+    uint8_t _head;
+    uint8_t _minFront;
+    uint8_t _minSize;
+    uint8_t _maxFront;
+    uint8_t _maxSize;
+    int64_t _sum;
+    int64_t _sumSquares;
+};
+
+enum AlarmFlags : uint8_t {
+    ALARM_NONE = 0,
+    ALARM_HIGH = 1 << 0,    // Above the high threshold
+    ALARM_LOW = 1 << 1,     // Below the low threshold
+    ALARM_RISE = 1 << 2,    // Rising faster than the rate limit
+    ALARM_FALL = 1 << 3     // Falling faster than the rate limit
+};
+
+template <uint8_t N, typename T = int32_t>
+class ChannelMonitor {
+public:
+    // Rate smoothing: each update moves the rate 1/2^RATE_SHIFT of the way
+    static const uint8_t RATE_SHIFT = 3;
+
+    ChannelMonitor()
+        : _low(INT32_MIN)
+        , _high(INT32_MAX)
+        , _hysteresis(0)
+        , _rateLimit(0)
+        , _rate(0)
+        , _lastMs(0)
+        , _alarms(ALARM_NONE)
+        , _changed(false)
+    {}
+
+    // Alarm outside [low, high]; it clears once back inside by hysteresis
+    void setThresholds(int32_t low, int32_t high, int32_t hysteresis = 0) {
+        _low = low;
+        _high = high;
+        _hysteresis = hysteresis;
+    }
+
+    // Alarm when the smoothed rate exceeds this many units per second
+    // (0 disables the rate alarms)
+    void setRateLimit(int32_t perSecond) { _rateLimit = perSecond; }
+
+    void reset() {
+        _stats.reset();
+        _rate = 0;
+        _alarms = ALARM_NONE;
+        _changed = false;
+    }
+
+    // Add a sample and re-evaluate the alarms
+    void add(uint32_t timeMs, int32_t value) {
+        if (_stats.getCount() > 0 && timeMs != _lastMs) {
+            int32_t instant = (int32_t)(((int64_t)value - _stats.getLatest()) * 1000 / (int32_t)(timeMs - _lastMs));
+            _rate += (instant - _rate) >> RATE_SHIFT;
+        }
+        _lastMs = timeMs;
+        _stats.add(value);
+
+        uint8_t alarms = _alarms;
+        alarms = update(alarms, ALARM_HIGH, value > _high, value <= _high - _hysteresis);
+        alarms = update(alarms, ALARM_LOW, value < _low, value >= _low + _hysteresis);
+        if (_rateLimit > 0) {
+            alarms = update(alarms, ALARM_RISE, _rate > _rateLimit, _rate <= _rateLimit / 2);
+            alarms = update(alarms, ALARM_FALL, _rate < -_rateLimit, _rate >= -_rateLimit / 2);
+        }
+
+        _changed = alarms != _alarms;
+        _alarms = alarms;
+    }
+
+    const RollingStats<N, T>& getStats() const { return _stats; }
+
+    // Smoothed rate of change in units per second
+    int32_t getRate() const { return _rate; }
+
+    uint8_t getAlarms() const { return _alarms; }
+
+    // True if the last add() raised or cleared an alarm
+    bool alarmsChanged() const { return _changed; }
+
+private:
+    static uint8_t update(uint8_t alarms, uint8_t flag, bool raise, bool clear) {
+        if (raise) return alarms | flag;
+        if (clear) return alarms & ~flag;
+        return alarms;
+    }
+
+    RollingStats<N, T> _stats;
+    int32_t _low;
+    int32_t _high;
+    int32_t _hysteresis;
+    int32_t _rateLimit;
+    int32_t _rate;
+    uint32_t _lastMs;
+    uint8_t _alarms;
+    bool _changed;
+};
+
+} // namespace Thermal
+
+#endif // ROLLING_STATS_H
@@ -0,0 +1,264 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+namespace Tasks {
+
+// Cooperative tickless scheduler
+//
+// Replaces delay()-paced loops: every job is a short function registered as
+// a task, and loop() just calls run(). There is no timer tick; each task
+// keeps its next release time in micros() and run() starts whichever ready
+// task has the earliest deadline (EDF), one per call. Tasks are never
+// preempted, so they must return quickly (poll, don't wait) - a task that
+// runs long delays everything else and shows up in the statistics.
+//
+// Two kinds of task:
+//   periodic - released every periodUs, on a fixed grid so it does not
+//              drift. If it falls more than a period behind, the missed
+//              releases are dropped and counted as skipped.
+//   event    - released by trigger(), e.g. from an ISR when an audio buffer
+//              half empties. trigger() is safe to call from interrupts.
+// Each task has a deadline relative to its release (default: its period,
+// or 1 ms for events). A task that finishes after its deadline counts as
+// late, with the worst lateness kept.
+//
+// Run-time accounting per task: runs, worst and total run time, late and
+// skipped releases. The scheduler also counts busy time, so getLoad() gives
+// the CPU share used by tasks since the last resetStats() (reset at least
+// every hour, micros() wraps after ~71 minutes).
+//
+// Everything is statically allocated: MAX_TASKS slots, no heap.
+//
+// Usage:
+//   Tasks::Scheduler<4> scheduler;
+//   void pollSensors() { pt100.poll(millis()); }
+//   void updateControl() { heater.setDuty(ch, pid.update(pt100.latest().centiC)); }
+//   setup() {
+//       scheduler.addPeriodic("sensors", pollSensors, 2000);           // 2 ms
+//       scheduler.addPeriodic("control", updateControl, 250000UL);     // 250 ms
+//       int8_t refill = scheduler.addEvent("audio", refillBuffer, 500);
+//       scheduler.begin();
+//   }
+//   ISR(...) { scheduler.trigger(refill); }
+//   loop() { scheduler.run(); }
+
+typedef void (*TaskFunction)();
+
+struct TaskStats {
+    uint32_t runs;
+    uint32_t totalUs;        // Sum of run times
+    uint32_t maxUs;          // Longest single run
+    uint16_t late;           // Finished after the deadline
+    uint16_t skipped;        // Periodic releases dropped while behind
+    uint32_t maxLatenessUs;  // Worst finish time past the deadline
+};
+
+struct Task {
+    const char *name;
+    TaskFunction function;
+    uint32_t periodUs;       // 0 for event tasks
+    uint32_t deadlineUs;     // Relative to the release
+    uint32_t releaseUs;      // Next (periodic) or pending (event) release
+    volatile bool pending;   // Event released and not yet run
+    bool enabled;
+    TaskStats stats;
+};
+
+template <uint8_t MAX_TASKS>
+class Scheduler {
+public:
+    static const uint32_t DEFAULT_EVENT_DEADLINE_US = 1000;
+
+    Scheduler()
+        : _count(0)
+        , _statsStartUs(0)
+        , _busyUs(0)
+    {}
+
+    // Add a task released every periodUs, first release at begin().
+    // Returns its id or -1 if the table is full.
+    int8_t addPeriodic(const char *name, TaskFunction function, uint32_t periodUs,
+                       uint32_t deadlineUs = 0) {
+        if (periodUs == 0) return -1;
+        return add(name, function, periodUs, deadlineUs ? deadlineUs : periodUs);
+    }
+
+    // Add a task released by trigger(). Returns its id or -1 if the table is full.
+    int8_t addEvent(const char *name, TaskFunction function,
+                    uint32_t deadlineUs = DEFAULT_EVENT_DEADLINE_US) {
+        return add(name, function, 0, deadlineUs);
+    }
+
+    // Start all periodic tasks now, spread by a phase if given (so tasks with
+    // the same period do not all fall due in the same pass)
+    void begin(uint32_t phaseUs = 0) {
+        uint32_t now = micros();
+        for (uint8_t i = 0; i < _count; i++) {
+            _tasks[i].releaseUs = now + i * phaseUs;
+        }
+        resetStats();
+    }
+
+    // Release an event task (or run a periodic one early). ISR safe.
+    void trigger(int8_t id) {
+        if (id < 0 || id >= _count) return;
+        Task& task = _tasks[id];
+        uint8_t oldSREG = SREG;
+        cli();
+        if (!task.pending) {
+            task.pending = true;
+            if (task.periodUs == 0) task.releaseUs = micros();
+        }
+        SREG = oldSREG;
+    }
+
+    void setEnabled(int8_t id, bool enabled) {
+        if (id < 0 || id >= _count) return;
+        Task& task = _tasks[id];
+        if (enabled && !task.enabled && task.periodUs > 0) {
+            task.releaseUs = micros();
+        }
+        task.enabled = enabled;
+    }
+
+    void setPeriod(int8_t id, uint32_t periodUs, uint32_t deadlineUs = 0) {
+        if (id < 0 || id >= _count || periodUs == 0 || _tasks[id].periodUs == 0) return;
+        _tasks[id].periodUs = periodUs;
+        _tasks[id].deadlineUs = deadlineUs ? deadlineUs : periodUs;
+    }
+
+    // Run the ready task with the earliest deadline. Returns true if a task ran.
+    bool run() {
+        uint32_t now = micros();
+        int8_t next = -1;
+        uint32_t nextDeadline = 0;
+
+        for (uint8_t i = 0; i < _count; i++) {
+            Task& task = _tasks[i];
+
+            // trigger() writes both from interrupts
+            uint8_t oldSREG = SREG;
+            cli();
+            bool pending = task.pending;
+            uint32_t releaseUs = task.releaseUs;
+            SREG = oldSREG;
+
+            if (!isReady(task, pending, releaseUs, now)) continue;
+            uint32_t deadline = releaseOf(task, pending, releaseUs) + task.deadlineUs;
+            if (next < 0 || (int32_t)(deadline - nextDeadline) < 0) {
+                next = i;
+                nextDeadline = deadline;
+            }
+        }
+        if (next < 0) return false;
+
+        Task& task = _tasks[next];
+        task.pending = false;
+        if (task.periodUs > 0 && (int32_t)(now - task.releaseUs) >= 0) advance(task, now);
+
+        uint32_t start = micros();
+        task.function();
+        uint32_t finish = micros();
+
+        uint32_t elapsed = finish - start;
+        _busyUs += elapsed;
+        task.stats.runs++;
+        task.stats.totalUs += elapsed;
+        if (elapsed > task.stats.maxUs) task.stats.maxUs = elapsed;
+
+        int32_t lateness = (int32_t)(finish - nextDeadline);
+        if (lateness > 0) {
+            if (task.stats.late < 0xFFFF) task.stats.late++;
+            if ((uint32_t)lateness > task.stats.maxLatenessUs) task.stats.maxLatenessUs = lateness;
+        }
+        return true;
+    }
+
+    // Microseconds until the next periodic release (0 if something is ready).
+    // Useful to decide whether there is time to sleep or do background work.
+    uint32_t getIdleUs() const {
+        uint32_t now = micros();
+        uint32_t idle = 0xFFFFFFFFUL;
+        for (uint8_t i = 0; i < _count; i++) {
+            const Task& task = _tasks[i];
+            if (!task.enabled) continue;
+            if (task.pending) return 0;
+            if (task.periodUs == 0) continue;
+            int32_t wait = (int32_t)(task.releaseUs - now);
+            if (wait <= 0) return 0;
+            if ((uint32_t)wait < idle) idle = wait;
+        }
+        return idle;
+    }
+
+    // Share of time spent in tasks since resetStats(), 0-1000 (per mille)
+    uint16_t getLoad() const {
+        uint32_t window = micros() - _statsStartUs;
+        if (window == 0) return 0;
+        return (uint16_t)((uint64_t)_busyUs * 1000 / window);
+    }
+
+    void resetStats() {
+        for (uint8_t i = 0; i < _count; i++) {
+            memset(&_tasks[i].stats, 0, sizeof(TaskStats));
+        }
+        _statsStartUs = micros();
+        _busyUs = 0;
+    }
+
+    const Task& task(uint8_t id) const { return _tasks[id]; }
+    uint8_t getCount() const { return _count; }
+
+private:
+    int8_t add(const char *name, TaskFunction function, uint32_t periodUs, uint32_t deadlineUs) {
+        if (_count >= MAX_TASKS || function == 0) return -1;
+
+        Task& task = _tasks[_count];
+        task.name = name;
+        task.function = function;
+        task.periodUs = periodUs;
+        task.deadlineUs = deadlineUs;
+        task.releaseUs = micros();
+        task.pending = false;
+        task.enabled = true;
+        memset(&task.stats, 0, sizeof(TaskStats));
+        return _count++;
+    }
+
+    static bool isReady(const Task& task, bool pending, uint32_t releaseUs, uint32_t now) {
+        if (!task.enabled) return false;
+        if (pending) return true;
+        return task.periodUs > 0 && (int32_t)(now - releaseUs) >= 0;
+    }
+
+    // Release time the deadline counts from
+    static uint32_t releaseOf(const Task& task, bool pending, uint32_t releaseUs) {
+        // A periodic task triggered early is treated as released now
+        if (pending && task.periodUs > 0) return micros();
+        return releaseUs;
+    }
+
+    // Move a periodic task to its next release on the grid
+    static void advance(Task& task, uint32_t now) {
+        task.releaseUs += task.periodUs;
+        if ((int32_t)(now - task.releaseUs) >= (int32_t)task.periodUs) {
+            // More than a period behind: drop the backlog instead of
+            // running the task back to back to catch up
+            uint32_t missed = (now - task.releaseUs) / task.periodUs;
+            task.releaseUs += missed * task.periodUs;
+            uint32_t skipped = task.stats.skipped + missed;
+            task.stats.skipped = skipped > 0xFFFF ? 0xFFFF : skipped;
+        }
+    }
+
+    Task _tasks[MAX_TASKS];
+    uint8_t _count;
+    uint32_t _statsStartUs;
+    uint32_t _busyUs;
+};
+
+} // namespace Tasks
+
+#endif // SCHEDULER_H
@@ -0,0 +1,316 @@
+#ifndef SEGMENT_ENVELOPE_H
+#define SEGMENT_ENVELOPE_H
+
+#include <Arduino.h>
+#include "envelope_curve.h"
+
+namespace Synth {
+
+// Multi-segment breakpoint envelope
+//
+// Up to N breakpoints of (time, level, curve). Segment i runs from wherever
+// the envelope is to breakpoint i's level in breakpoint i's time, so the
+// envelope starts at its current level (0 after reset) and each segment
+// picks up where the last one ended. curve shapes the segment:
+//   0          straight line
+//   1 to 127   fast start, slow finish (RC/analog style, like ADSR decays)
+//   -1 to -127 slow start, fast finish
+// with larger magnitudes curving more (see EnvelopeCurve: the target sits
+// 4 * 2^(-|curve|/8) spans past the end, e.g. 30 ~ the ADSR attack).
+//
+// Sustain point: with the gate on, the envelope holds at that breakpoint's
+// level. Loop: with the gate on, finishing the loop end segment goes back
+// to the loop start segment (from the current level), for repeating or
+// evolving shapes. noteOff() jumps from either to the segment after the
+// sustain point (or loop end) and plays the rest as the release; if that
+// is the last breakpoint, it releases to 0 in that breakpoint's time and
+// curve. Without a sustain point or loop the envelope is a one-shot and
+// ignores noteOff().
+//
+// Like ADSR, render() fills whole runs of a segment with a precomputed
+// per-sample step (a 32-bit add for lines, an EnvelopeCurve step for
+// curves) and no state checks, so a complex envelope costs the same per
+// sample as the simple ADSR. Starting a segment is integer only, as it
+// happens inside render(). Each breakpoint is 4 bytes plus 15 bytes of
+// precomputed segment data.
+//
+// Usage (DAHDSR):
+//   SegmentEnvelope<6> env(22050);
+//   env.addBreakpoint(20, 0);            // delay 20 ms
+//   env.addBreakpoint(5, 255, 30);       // attack 5 ms
+//   env.addBreakpoint(50, 255);          // hold 50 ms
+//   int8_t s = env.addBreakpoint(300, 140, 100);   // decay to sustain
+//   env.addBreakpoint(400, 0, 100);      // release
+//   env.setSustainPoint(s);
+//   env.noteOn(); ... env.render(levels, 32); ... env.noteOff();
+
+template <uint8_t N>
+class SegmentEnvelope {
+public:
+    static const uint8_t NONE = 0xFF;
+
+    struct Breakpoint {
+        uint16_t timeMs;
+        uint8_t level;
+        int8_t curve;
+    };
+
+    SegmentEnvelope(uint32_t sampleRate = 44100)
+        : _sampleRate(sampleRate)
+    {
+        clear();
+    }
+
+    // Remove all breakpoints, sustain and loop, and go idle at level 0
+    void clear() {
+        _count = 0;
+        _sustain = NONE;
+        _loopStart = NONE;
+        _loopEnd = NONE;
+        _gate = false;
+        reset();
+    }
+
+    // Append a breakpoint. Returns its index or -1 if full.
+    int8_t addBreakpoint(uint16_t timeMs, uint8_t level, int8_t curve = 0) {
+        if (_count >= N) return -1;
+        _count++;
+        setBreakpoint(_count - 1, timeMs, level, curve);
+        return _count - 1;
+    }
+
+    // Change a breakpoint. Takes effect the next time its segment starts.
+    void setBreakpoint(uint8_t index, uint16_t timeMs, uint8_t level, int8_t curve = 0) {
+        if (index >= _count) return;
+        Breakpoint& point = _points[index];
+        point.timeMs = timeMs;
+        point.level = level;
+        point.curve = curve;
+        prepare(index);
+    }
+
+    // Hold at this breakpoint's level while the gate is on (NONE: no sustain)
+    void setSustainPoint(uint8_t index) {
+        _sustain = index < _count ? index : NONE;
+    }
+
+    // Repeat segments start..end while the gate is on (NONE: no loop)
+    void setLoop(uint8_t start, uint8_t end) {
+        if (start <= end && end < _count) {
+            _loopStart = start;
+            _loopEnd = end;
+        } else {
+            _loopStart = _loopEnd = NONE;
+        }
+    }
+
+    void noteOn() {
+        _gate = true;
+        if (_count > 0) startSegment(0);
+    }
+
+    void noteOff() {
+        bool gate = _gate;
+        _gate = false;
+        uint8_t releaseAfter = _sustain != NONE ? _sustain : _loopEnd;
+        if (!gate || releaseAfter == NONE || _segment == NONE) return;
+        if (_segment > releaseAfter && !_holding) return;   // Already releasing
+
+        if (releaseAfter + 1 < _count) {
+            startSegment(releaseAfter + 1);
+        } else {
+            // Nothing after it: fall to 0, so the envelope never goes idle
+            // at a non-zero level
+            startSegment(releaseAfter, 0);
+        }
+    }
+
+    // Fill levels with the next count envelope samples (0-255)
+    void render(uint8_t* levels, uint16_t count) {
+        while (count > 0) {
+            if (_segment == NONE || _holding) {
+                // Flat until the next event
+                memset(levels, _level >> 20, count);
+                return;
+            }
+            if (_remaining == 0) {
+                finishSegment();
+                continue;
+            }
+
+            // The rest of this segment, or of the buffer
+            uint16_t run = _remaining < count ? _remaining : count;
+            _remaining -= run;
+            count -= run;
+
+            const Segment& segment = _segments[_segment];
+            if (_shape == LINE) {
+                int32_t level = _level;
+                for (uint16_t i = 0; i < run; i++) {
+                    level += _increment;
+                    *levels++ = level >> 20;
+                }
+                _level = level;
+            } else {
+                // Held at the end of the segment, so rounding never takes
+                // the level past it (or wraps it past 0 or 255). distance
+                // keeps its sign through the segment, so it has passed end
+                // when distance - end turns to the other side of 0: towards
+                // 0 when shrinking, away from it when growing.
+                int32_t distance = _level - _anchor;
+                int32_t end = _end - _anchor;
+                if (_shape == SHRINK) {
+                    for (uint16_t i = 0; i < run; i++) {
+                        distance -= segment.coefficient.step(distance);
+                        if (((distance - end) ^ end) < 0) distance = end;
+                        *levels++ = (_anchor + distance) >> 20;
+                    }
+                } else {
+                    uint32_t carry = _carry;
+                    for (uint16_t i = 0; i < run; i++) {
+                        distance += segment.coefficient.step(distance, carry);
+                        if (((end - distance) ^ end) < 0) distance = end;
+                        *levels++ = (_anchor + distance) >> 20;
+                    }
+                    _carry = carry;
+                }
+                _level = _anchor + distance;
+            }
+        }
+    }
+
+    // Get next envelope sample (0-255)
+    uint8_t nextSample() {
+        uint8_t level;
+        render(&level, 1);
+        return level;
+    }
+
+    // Go idle at level 0
+    void reset() {
+        _segment = NONE;
+        _holding = false;
+        _level = 0;
+        _remaining = 0;
+    }
+
+    void setSampleRate(uint32_t rate) {
+        _sampleRate = rate;
+        for (uint8_t i = 0; i < _count; i++) prepare(i);
+    }
+
+    const Breakpoint& breakpoint(uint8_t index) const { return _points[index]; }
+    uint8_t getCount() const { return _count; }
+
+    // Segment being played, NONE when idle
+    uint8_t getSegment() const { return _segment; }
+    bool isHolding() const { return _holding; }
+    bool isActive() const { return _segment != NONE; }
+    uint8_t getLevel() const { return _level >> 20; }
+
+private:
+    enum Shape : uint8_t {
+        LINE,
+        SHRINK,     // Fast start: distance to a target past the end shrinks
+        GROW        // Slow start: distance from an origin before the start grows
+    };
+
+    // Per-breakpoint data worked out when the breakpoint is set
+    struct Segment {
+        uint32_t samples;
+        uint32_t reciprocal;        // 2^32 / samples, for the line increment
+        uint32_t ratio;             // Target/origin offset in segment spans, 1/2^20
+        EnvelopeCurve coefficient;
+    };
+
+    void prepare(uint8_t index) {
+        const Breakpoint& point = _points[index];
+        Segment& segment = _segments[index];
+        segment.samples = ((uint32_t)point.timeMs * _sampleRate) / 1000;
+        if (segment.samples == 0) segment.samples = 1;
+        segment.reciprocal = 0xFFFFFFFFUL / segment.samples;
+        if (point.curve != 0) {
+            uint8_t magnitude = point.curve < 0 ? -point.curve : point.curve;
+            segment.ratio = (uint32_t)(4194304.0f * pow(2.0f, -magnitude / 8.0f) + 0.5f);
+            // The curve must use the rounded ratio too, or the anchor misses
+            segment.coefficient.set(segment.samples, segment.ratio / 1048576.0f, point.curve < 0);
+        }
+    }
+
+    // Start segment index from the current level
+    void startSegment(uint8_t index) {
+        startSegment(index, _points[index].level);
+    }
+
+    // The same towards another end level
+    void startSegment(uint8_t index, uint8_t level) {
+        const Breakpoint& point = _points[index];
+        const Segment& segment = _segments[index];
+        _segment = index;
+        _holding = false;
+        _end = (int32_t)level << 20;
+
+        // One sample short: finishSegment() lands exactly on the end, so
+        // rounding can never carry the level past it
+        _remaining = segment.samples > 1 ? segment.samples - 1 : 1;
+
+        // A single sample has no shape: a growing curve could not cover
+        // the span in one step
+        int32_t span = _end - _level;
+        if (point.curve == 0 || span == 0 || segment.samples == 1) {
+            // span / samples, rounded towards 0 so it cannot overshoot
+            _shape = LINE;
+            uint32_t magnitude = span < 0 ? -(uint32_t)span : span;
+            int32_t increment = ((uint64_t)magnitude * segment.reciprocal) >> 32;
+            _increment = span < 0 ? -increment : increment;
+            return;
+        }
+
+        int32_t offset = ((int64_t)span * segment.ratio) >> 20;
+        if (point.curve > 0) {
+            _shape = SHRINK;
+            _anchor = _end + offset;
+        } else {
+            _shape = GROW;
+            _anchor = _level - offset;
+            _carry = 0;
+        }
+    }
+
+    void finishSegment() {
+        _level = _end;
+        if (_gate && _segment == _sustain) {
+            _holding = true;
+        } else if (_gate && _segment == _loopEnd) {
+            startSegment(_loopStart);
+        } else if (_segment + 1 < _count) {
+            startSegment(_segment + 1);
+        } else {
+            _segment = NONE;
+        }
+    }
+
+    uint32_t _sampleRate;
+    Breakpoint _points[N];
+    Segment _segments[N];
+    uint8_t _count;
+    uint8_t _sustain;
+    uint8_t _loopStart;
+    uint8_t _loopEnd;
+    bool _gate;
+
+    // Current segment
+    uint8_t _segment;          // NONE when idle
+    bool _holding;             // At the sustain point
+    Shape _shape;
+    int32_t _level;            // Output level << 20
+    int32_t _end;
+    int32_t _increment;        // LINE: per sample
+    int32_t _anchor;           // SHRINK: target, GROW: origin
+    uint32_t _carry;           // GROW: step bits carried between samples
+    uint32_t _remaining;       // Samples left in the segment
+};
+
+} // namespace Synth
+
+#endif // SEGMENT_ENVELOPE_H
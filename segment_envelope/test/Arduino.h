@@ -0,0 +1,20 @@
+// Host stand-in for the Arduino core, just enough for the Synth headers
+// (SegmentEnvelope, EnvelopeCurve, table_gen) to build with the native
+// compiler. PROGMEM is ordinary memory here.
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_word(p) (*(const uint16_t*)(p))
+#define pgm_read_dword(p) (*(const uint32_t*)(p))
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,141 @@
+// SegmentEnvelope curve test
+//
+// Plays random segments (levels, times, sample rates) with every curve from
+// -127 to 127 and checks each sample against the exact exponential (or
+// line) the segment stands for: the level must move monotonically, never
+// leave [start, end] and stay within TOLERANCE of the exact curve, and the
+// segment must end on its level. Exits non-zero on the first failures.
+//
+// Build (on the host, Arduino.h here stands in for the core):
+//   g++ -std=gnu++11 -O2 -I. -I.. -I../../adsr -I../../table_gen -o segment_envelope_test segment_envelope_test.cpp
+//
+// Run:
+//   ./segment_envelope_test
+
+#include <stdio.h>
+#include "segment_envelope.h"
+
+using namespace Synth;
+
+static const int TOLERANCE = 2;          // Output levels
+static const int SEGMENTS_PER_CURVE = 40;
+static const int MAX_FAILURES = 10;
+
+static int failures = 0;
+
+// Exact level t samples into a segment of samples samples from start to end
+static double exactLevel(int start, int end, int curve, uint32_t samples, uint32_t t) {
+    double position = (double)t / samples;
+    if (curve == 0) return start + (end - start) * position;
+
+    double ratio = 4.0 * pow(2.0, -abs(curve) / 8.0);
+    double span = end - start;
+    if (curve > 0) {
+        // Distance to a target past the end shrinks by ratio / (1 + ratio)
+        double target = end + ratio * span;
+        return target + (start - target) * pow(ratio / (1 + ratio), position);
+    }
+    // Distance from an origin before the start grows by (1 + ratio) / ratio
+    double origin = start - ratio * span;
+    return origin + (start - origin) * pow((1 + ratio) / ratio, position);
+}
+
+static void fail(int curve, int start, int end, uint16_t ms, uint32_t rate,
+                 uint32_t t, int level, double exact, const char* what) {
+    if (failures++ < MAX_FAILURES) {
+        printf("FAIL curve %d, %d -> %d in %u ms at %lu Hz: sample %lu level %d (exact %.2f), %s\n",
+               curve, start, end, ms, (unsigned long)rate, (unsigned long)t, level, exact, what);
+    }
+}
+
+static void testSegment(int curve, int start, int end, uint16_t ms, uint32_t rate) {
+    // Jump to start, then one segment to end
+    SegmentEnvelope<2> env(rate);
+    env.addBreakpoint(0, start);
+    env.addBreakpoint(ms, end, curve);
+    env.noteOn();
+    while (env.getSegment() == 0) env.nextSample();
+
+    uint32_t samples = ((uint32_t)ms * rate) / 1000;
+    if (samples == 0) samples = 1;
+    int low = start < end ? start : end;
+    int high = start < end ? end : start;
+    int previous = start;
+
+    // The sample that left segment 0 was the first one of segment 1
+    int level = env.getLevel();
+    for (uint32_t t = 1; t <= samples; t++) {
+        if (t > 1) level = env.nextSample();
+        double exact = exactLevel(start, end, curve, samples, t);
+
+        if (level < low || level > high) {
+            fail(curve, start, end, ms, rate, t, level, exact, "outside the segment");
+            return;
+        }
+        if ((end > start && level < previous) || (end < start && level > previous)) {
+            fail(curve, start, end, ms, rate, t, level, exact, "reversed");
+            return;
+        }
+        if (fabs(level - exact) > TOLERANCE) {
+            fail(curve, start, end, ms, rate, t, level, exact, "off the curve");
+            return;
+        }
+        previous = level;
+    }
+
+    level = env.nextSample();
+    if (level != end || env.isActive()) {
+        fail(curve, start, end, ms, rate, samples + 1, level, end, "did not end on its level");
+    }
+}
+
+// Releasing from a sustain point with no breakpoint after it must still
+// fall to 0 before the envelope goes idle
+static void testReleaseFromLast() {
+    SegmentEnvelope<2> env(44100);
+    env.addBreakpoint(10, 255);
+    env.addBreakpoint(10, 140);
+    env.setSustainPoint(1);
+    env.noteOn();
+    for (int i = 0; i < 2000; i++) env.nextSample();
+    env.noteOff();
+
+    uint32_t samples = 0;
+    int previous = env.getLevel();
+    while (env.isActive() && samples < 1000) {
+        int level = env.nextSample();
+        if (level > previous) break;
+        previous = level;
+        samples++;
+    }
+    int level = env.nextSample();
+    if (level != 0 || env.isActive()) {
+        fail(0, 140, 0, 10, 44100, samples, level, 0, "release from the last breakpoint stuck");
+    }
+}
+
+int main() {
+    srand(1);
+    uint32_t segments = 0;
+    for (int curve = -127; curve <= 127; curve++) {
+        for (int i = 0; i < SEGMENTS_PER_CURVE; i++) {
+            int start = rand() % 256;
+            int end = rand() % 256;
+            uint16_t ms = rand() % 2000;
+            uint32_t rate = rand() % 2 ? 44100 : 22050;
+            testSegment(curve, start, end, ms, rate);
+            segments++;
+        }
+    }
+
+    // Reported cases: falling and rising slow-start curves that wrapped or stuck
+    testSegment(-119, 68, 6, 948, 44100);
+    testSegment(-121, 85, 128, 1311, 44100);
+    segments += 2;
+
+    testReleaseFromLast();
+    segments++;
+
+    printf("%lu segments, %d failures\n", (unsigned long)segments, failures);
+    return failures == 0 ? 0 : 1;
+}
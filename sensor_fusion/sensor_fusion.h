@@ -0,0 +1,222 @@
+#ifndef SENSOR_FUSION_H
+#define SENSOR_FUSION_H
+
+#include <Arduino.h>
+#include "temperature_source.h"
+
+namespace Thermal {
+
+// Kalman fusion of a fast biased sensor with a slow accurate one
+//
+// The MLX90614 responds quickly but reads off by an emissivity-dependent
+// bias; the PT100 is accurate but lags behind the part. TemperatureKalman
+// tracks the state [T, b]:
+//   T  true temperature (random walk, qTemp)
+//   b  IR bias         (slow random walk, qBias)
+// with two measurements:
+//   IR      z = T + b   noise rIR
+//   contact z = T       noise rContact + (rate * lag)^2
+// The contact noise is inflated while the temperature is moving, because a
+// lagging sensor is wrong by about rate * lag then. During ramps the filter
+// follows the IR reading; once things settle the PT100 pulls T back and
+// the difference is learned as bias, so later IR readings arrive corrected.
+//
+// Everything is integer: temperatures in centi-degrees C, variances in
+// centi-degrees squared, covariance updates in 64-bit.
+//
+// FusedTemperatureSource wraps the filter as a TemperatureSource that
+// publishes a new estimate at the rate of the fast sensor.
+//
+// Usage:
+//   MLXI2CSource ir(mlx, 20);
+//   PT100Source contact(A13, 100);
+//   FusedTemperatureSource fused(ir, contact);
+//   fused.filter().setIRNoise(20);            // 0.2 C
+//   fused.filter().setContactNoise(10, 4000); // 0.1 C, 4 s lag
+//   loop() {
+//       if (fused.poll(millis())) pid.update(fused.latest().centiC);
+//   }
+
+class TemperatureKalman {
+public:
+    // Variance the state starts with, (10 C)^2
+    static const int32_t INITIAL_VARIANCE = 1000000L;
+    // Keep variances far from overflow in the 64-bit products
+    static const int32_t MAX_VARIANCE = 100000000L;
+    // Rate smoothing: each update moves the rate 1/2^RATE_SHIFT of the way
+    static const uint8_t RATE_SHIFT = 4;
+
+    TemperatureKalman() {
+        setIRNoise(20);
+        setContactNoise(10, 0);
+        setProcessNoise(20, 1);
+        reset();
+    }
+
+    void reset() {
+        _initialised = false;
+        _temperature = 0;
+        _bias = 0;
+        _p00 = INITIAL_VARIANCE;
+        _p01 = 0;
+        _p11 = INITIAL_VARIANCE;
+        _rate = 0;
+        _lastMs = 0;
+        _dtMs = 0;
+    }
+
+    // Standard deviation of the IR reading noise, centi-degrees
+    void setIRNoise(uint16_t stddev) { _rIR = (int32_t)stddev * stddev; }
+
+    // Standard deviation of the contact reading noise and its lag
+    void setContactNoise(uint16_t stddev, uint16_t lagMs) {
+        _rContact = (int32_t)stddev * stddev;
+        _lagMs = lagMs;
+    }
+
+    // How far T and the bias may wander, centi-degrees per sqrt(second)
+    void setProcessNoise(uint16_t temperature, uint16_t bias) {
+        _qTemp = (int32_t)temperature * temperature;
+        _qBias = (int32_t)bias * bias;
+    }
+
+    void updateIR(uint32_t nowMs, int32_t z) {
+        if (!_initialised) {
+            _temperature = z;
+            _initialised = true;
+            _lastMs = nowMs;
+            return;
+        }
+        predict(nowMs);
+        correct(z, true, _rIR);
+    }
+
+    void updateContact(uint32_t nowMs, int32_t z) {
+        if (!_initialised) {
+            _temperature = z;
+            _initialised = true;
+            _lastMs = nowMs;
+            return;
+        }
+        predict(nowMs);
+
+        // A lagging sensor is off by about rate * lag while moving
+        int64_t lagError = (int64_t)_rate * _lagMs / 1000;
+        int64_t r = _rContact + lagError * lagError;
+        correct(z, false, r > MAX_VARIANCE ? MAX_VARIANCE : (int32_t)r);
+    }
+
+    bool isInitialised() const { return _initialised; }
+    int32_t getTemperature() const { return _temperature; }
+    int32_t getBias() const { return _bias; }
+
+    // Smoothed rate of change of the estimate, centi-degrees per second
+    int32_t getRate() const { return _rate; }
+
+    // Variance of the temperature estimate, centi-degrees squared
+    int32_t getVariance() const { return _p00; }
+
+private:
+    void predict(uint32_t nowMs) {
+        // Readings may arrive slightly out of order between the sensors
+        uint32_t dt = (int32_t)(nowMs - _lastMs) > 0 ? nowMs - _lastMs : 0;
+        if (dt > 0) _lastMs = nowMs;
+        _p00 = clampVariance((int64_t)_p00 + (int64_t)_qTemp * dt / 1000);
+        _p11 = clampVariance((int64_t)_p11 + (int64_t)_qBias * dt / 1000);
+        _dtMs = dt;
+    }
+
+    // Measurement z = T + (withBias ? b : 0), noise variance r
+    void correct(int32_t z, bool withBias, int32_t r) {
+        // a, c = P * H^T
+        int64_t a = withBias ? (int64_t)_p00 + _p01 : _p00;
+        int64_t c = withBias ? (int64_t)_p01 + _p11 : _p01;
+        int64_t s = (withBias ? a + c : a) + r;
+        if (s <= 0) return;
+
+        int64_t y = (int64_t)z - (withBias ? (int64_t)_temperature + _bias : _temperature);
+        int32_t previous = _temperature;
+
+        _temperature += a * y / s;
+        _bias += c * y / s;
+
+        // P = (I - K H) P, kept symmetric
+        _p00 = clampVariance(_p00 - a * a / s);
+        _p01 = _p01 - a * c / s;
+        _p11 = clampVariance(_p11 - c * c / s);
+
+        if (_dtMs > 0) {
+            int32_t instant = (int32_t)((int64_t)(_temperature - previous) * 1000 / _dtMs);
+            _rate += (instant - _rate) >> RATE_SHIFT;
+        }
+    }
+
+    static int32_t clampVariance(int64_t v) {
+        if (v < 1) return 1;
+        if (v > MAX_VARIANCE) return MAX_VARIANCE;
+        return (int32_t)v;
+    }
+
+    bool _initialised;
+    int32_t _temperature;
+    int32_t _bias;
+    int32_t _p00;
+    int32_t _p01;
+    int32_t _p11;
+    int32_t _rIR;
+    int32_t _rContact;
+    uint16_t _lagMs;
+    int32_t _qTemp;
+    int32_t _qBias;
+    int32_t _rate;
+    uint32_t _lastMs;
+    uint32_t _dtMs;
+};
+
+// Polls an IR and a contact source and publishes the fused estimate after
+// every new IR reading (or contact reading, while the IR is invalid)
+class FusedTemperatureSource : public TemperatureSource {
+public:
+    FusedTemperatureSource(TemperatureSource& ir, TemperatureSource& contact)
+        : _ir(ir)
+        , _contact(contact)
+    {}
+
+    void begin() override {
+        _ir.begin();
+        _contact.begin();
+        _filter.reset();
+    }
+
+    bool poll(uint32_t nowMs) override {
+        bool published = false;
+
+        if (_contact.poll(nowMs) && _contact.latest().valid) {
+            _filter.updateContact(_contact.latest().timeMs, _contact.latest().centiC);
+            if (!_ir.latest().valid) {
+                published = publish(nowMs, _filter.getTemperature(), true);
+            }
+        }
+
+        if (_ir.poll(nowMs)) {
+            if (_ir.latest().valid) {
+                _filter.updateIR(_ir.latest().timeMs, _ir.latest().centiC);
+                published = publish(nowMs, _filter.getTemperature(), true);
+            } else if (!_contact.latest().valid) {
+                published = publish(nowMs, 0, false);
+            }
+        }
+        return published;
+    }
+
+    TemperatureKalman& filter() { return _filter; }
+
+private:
+    TemperatureSource& _ir;
+    TemperatureSource& _contact;
+    TemperatureKalman _filter;
+};
+
+} // namespace Thermal
+
+#endif // SENSOR_FUSION_H
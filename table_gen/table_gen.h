@@ -0,0 +1,360 @@
+#ifndef TABLE_GEN_H
+#define TABLE_GEN_H
+
+#include <Arduino.h>
+
+namespace Synth {
+
+// Compile-time lookup table generation
+//
+// Tables are computed by the compiler from a generator instead of being
+// pasted in as literals, so they cannot contain transcription errors and
+// can be specialised per build (size, bit depth, sample rate) without any
+// runtime initialisation. GeneratedTable<Generator>::values is an ordinary
+// PROGMEM array, read with pgm_read_word() etc. as before.
+//
+// Generators:
+//   SineQuarterGenerator<STEPS, BITS, T>      first quarter of a sine, STEPS+1 entries
+//   MidiFrequencyGenerator<FRACTION_BITS, T>  note 0-127 -> Hz, fixed point
+//   PhaseIncrementGenerator<SAMPLE_RATE, PHASE_BITS, T>
+//                                             note 0-127 -> phase step per sample
+//   Exp2Generator<STEPS, FRACTION_BITS, T, SPAN_CENTS>
+//                                             2^x over one octave (or SPAN_CENTS), STEPS+1 entries
+//   TanhGenerator<STEPS, RANGE, BITS, T>      tanh(x) for x = 0..RANGE, STEPS+1 entries
+//   Log2Generator<STEPS, FRACTION_BITS, T>    log2(x) over one octave, STEPS+1 entries
+//
+// Every table checks at compile time that all of its values fit T, and the
+// generators check their own error bounds (interpolation error under one
+// LSB, frequency quantisation under one cent), so an undersized
+// specialisation fails to build instead of sounding wrong.
+//
+// The maths runs in the compiler's double, which is 32-bit on AVR: enough
+// for 16-bit tables and 32-bit phase increments (~0.0002 cent).
+//
+// Usage:
+//   typedef GeneratedTable<PhaseIncrementGenerator<22050> > NoteIncrements;
+//   uint32_t increment = pgm_read_dword(&NoteIncrements::values[note]);
+
+namespace TableMath {
+
+// C++11 constexpr functions are a single return statement, so the loops
+// below are written as recursion
+
+constexpr double PI_DOUBLE = 3.14159265358979323846;
+constexpr double LN2 = 0.69314718055994530942;
+
+constexpr double absolute(double x) {
+    return x < 0 ? -x : x;
+}
+
+constexpr double floorOf(double x) {
+    return (double)(int32_t)x > x ? (double)(int32_t)x - 1 : (double)(int32_t)x;
+}
+
+constexpr int64_t roundOf(double x) {
+    return x < 0 ? -(int64_t)(0.5 - x) : (int64_t)(x + 0.5);
+}
+
+// Taylor series, |x| <= pi
+constexpr double sineSeries(double x2, double term, double sum, uint8_t n) {
+    return n > 15 ? sum : sineSeries(x2, -term * x2 / ((2 * n) * (2 * n + 1)), sum + term, n + 1);
+}
+
+constexpr double sineReduced(double x) {
+    return sineSeries(x * x, x, 0, 1);
+}
+
+constexpr double sine(double x) {
+    return sineReduced(x - 2 * PI_DOUBLE * floorOf((x + PI_DOUBLE) / (2 * PI_DOUBLE)));
+}
+
+// Taylor series, 0 <= x < 1
+constexpr double expSeries(double x, double term, double sum, uint8_t n) {
+    return n > 15 ? sum : expSeries(x, term * x / n, sum + term, n + 1);
+}
+
+constexpr double pow2Int(int16_t k) {
+    return k == 0 ? 1 : k > 0 ? 2 * pow2Int(k - 1) : 0.5 * pow2Int(k + 1);
+}
+
+constexpr double exp2(double x) {
+    return pow2Int((int16_t)floorOf(x)) * expSeries((x - floorOf(x)) * LN2, 1, 0, 1);
+}
+
+constexpr double tanh(double x) {
+    return 1 - 2 / (exp2(2 * x / LN2) + 1);
+}
+
+// ln x = 2 atanh(z), z = (x - 1) / (x + 1), as a series in z (|z| <= 1/3
+// over one octave)
+constexpr double atanhSeries(double z2, double term, double sum, uint8_t n) {
+    return n > 15 ? sum : atanhSeries(z2, term * z2, sum + term / (2 * n + 1), n + 1);
+}
+
+// 1 <= x <= 2
+constexpr double log2(double x) {
+    return 2 * atanhSeries((x - 1) / (x + 1) * (x - 1) / (x + 1), (x - 1) / (x + 1), 0, 0) / LN2;
+}
+
+// Equal temperament, A4 (note 69) = referenceHz
+constexpr double noteFrequency(uint8_t note, double referenceHz = 440) {
+    return referenceHz * exp2((note - 69) / 12.0);
+}
+
+// Relative frequency step of one cent, 2^(1/1200) - 1
+constexpr double CENT = 5.7780e-4;
+
+// Worst linear interpolation error between entries spaced step apart, for a
+// function whose second derivative is at most curvature (in output units)
+constexpr double interpolationError(double curvature, double step) {
+    return curvature * step * step / 8;
+}
+
+static_assert(absolute(sine(PI_DOUBLE / 6) - 0.5) < 1e-6, "constexpr sine is inaccurate");
+static_assert(absolute(sine(-5 * PI_DOUBLE / 2) + 1) < 1e-6, "constexpr sine range reduction is wrong");
+static_assert(absolute(exp2(0.5) - 1.41421356) < 1e-6, "constexpr exp2 is inaccurate");
+static_assert(absolute(exp2(-5.75) - 0.01858136) < 1e-8, "constexpr exp2 is inaccurate");
+static_assert(absolute(tanh(1) - 0.76159416) < 1e-6, "constexpr tanh is inaccurate");
+static_assert(absolute(log2(1.5) - 0.58496250) < 1e-6, "constexpr log2 is inaccurate");
+
+// Range of the integer types tables are stored in
+template <typename T> struct TypeRange;
+template <> struct TypeRange<uint8_t> { static constexpr int64_t MIN = 0, MAX = 0xFF; };
+template <> struct TypeRange<int8_t> { static constexpr int64_t MIN = -128, MAX = 127; };
+template <> struct TypeRange<uint16_t> { static constexpr int64_t MIN = 0, MAX = 0xFFFF; };
+template <> struct TypeRange<int16_t> { static constexpr int64_t MIN = -32768, MAX = 32767; };
+template <> struct TypeRange<uint32_t> { static constexpr int64_t MIN = 0, MAX = 0xFFFFFFFFLL; };
+template <> struct TypeRange<int32_t> { static constexpr int64_t MIN = -2147483648LL, MAX = 2147483647LL; };
+
+// Index packs 0..N-1 for the table initialisers, built by halving so the
+// template depth stays logarithmic
+template <uint16_t... I> struct IndexSequence {};
+
+template <class A, class B> struct ConcatIndices;
+template <uint16_t... A, uint16_t... B>
+struct ConcatIndices<IndexSequence<A...>, IndexSequence<B...> > {
+    typedef IndexSequence<A..., (uint16_t)(sizeof...(A) + B)...> Type;
+};
+
+template <uint16_t N> struct MakeIndices {
+    typedef typename ConcatIndices<typename MakeIndices<N / 2>::Type,
+                                   typename MakeIndices<N - N / 2>::Type>::Type Type;
+};
+template <> struct MakeIndices<0> { typedef IndexSequence<> Type; };
+template <> struct MakeIndices<1> { typedef IndexSequence<0> Type; };
+
+// True if every rounded entry in [first, last) fits T (split in halves, so
+// the constexpr recursion depth stays logarithmic too)
+template <class Generator>
+constexpr bool allFit(uint16_t first, uint16_t last) {
+    return last - first == 1
+        ? roundOf(Generator::exact(first)) >= TypeRange<typename Generator::Value>::MIN
+            && roundOf(Generator::exact(first)) <= TypeRange<typename Generator::Value>::MAX
+        : allFit<Generator>(first, first + (last - first) / 2)
+            && allFit<Generator>(first + (last - first) / 2, last);
+}
+
+} // namespace TableMath
+
+// PROGMEM array of Generator::SIZE entries of Generator::Value
+template <class Generator,
+          class Indices = typename TableMath::MakeIndices<Generator::SIZE>::Type>
+struct GeneratedTable;
+
+template <class Generator, uint16_t... I>
+struct GeneratedTable<Generator, TableMath::IndexSequence<I...> > {
+    typedef typename Generator::Value Value;
+    static const uint16_t SIZE = sizeof...(I);
+
+    static_assert(TableMath::allFit<Generator>(0, SIZE), "Table values overflow the table type");
+
+    static const Value values[sizeof...(I)];
+};
+
+template <class Generator, uint16_t... I>
+const typename Generator::Value
+GeneratedTable<Generator, TableMath::IndexSequence<I...> >::values[sizeof...(I)] PROGMEM = {
+    (typename Generator::Value)TableMath::roundOf(Generator::exact(I))...
+};
+
+// Quarter-wave sine, round(A * sin(pi/2 * i/STEPS)) for i = 0..STEPS with
+// A = 2^(BITS-1) - 1. Both ends are included so interpolation never wraps.
+template <uint16_t STEPS = 256, uint8_t BITS = 16, typename T = uint16_t>
+struct SineQuarterGenerator {
+    typedef T Value;
+    static const uint16_t SIZE = STEPS + 1;
+    static constexpr double AMPLITUDE = TableMath::pow2Int(BITS - 1) - 1;
+
+    static_assert(STEPS >= 2, "Sine table needs at least two steps");
+    static_assert(TableMath::interpolationError(AMPLITUDE, TableMath::PI_DOUBLE / 2 / STEPS) < 1,
+                  "Sine table too short for its bit depth: interpolation error over 1 LSB");
+
+    static constexpr double exact(uint16_t i) {
+        return AMPLITUDE * TableMath::sine(TableMath::PI_DOUBLE / 2 * i / STEPS);
+    }
+};
+
+// Frequency of MIDI notes 0-127 in Hz with FRACTION_BITS fraction bits
+template <uint8_t FRACTION_BITS = 8, typename T = uint32_t, uint16_t REFERENCE_HZ = 440>
+struct MidiFrequencyGenerator {
+    typedef T Value;
+    static const uint16_t SIZE = 128;
+    static constexpr double SCALE = TableMath::pow2Int(FRACTION_BITS);
+
+    static_assert(0.5 / (TableMath::noteFrequency(0, REFERENCE_HZ) * SCALE) < TableMath::CENT,
+                  "Too few fraction bits: low notes quantised by more than a cent");
+
+    static constexpr double exact(uint16_t note) {
+        return TableMath::noteFrequency(note, REFERENCE_HZ) * SCALE;
+    }
+};
+
+// Phase increment per sample of MIDI notes 0-127 for a 2^PHASE_BITS phase
+// accumulator. Notes above Nyquist are held at the Nyquist increment, like
+// Oscillator::setFrequency() does.
+template <uint32_t SAMPLE_RATE, uint8_t PHASE_BITS = 32, typename T = uint32_t>
+struct PhaseIncrementGenerator {
+    typedef T Value;
+    static const uint16_t SIZE = 128;
+    static constexpr double CYCLE = TableMath::pow2Int(PHASE_BITS);
+
+    static_assert(PHASE_BITS <= 8 * sizeof(T), "Phase accumulator wider than the table type");
+    static_assert(0.5 * SAMPLE_RATE / (TableMath::noteFrequency(0) * CYCLE) < TableMath::CENT,
+                  "Phase accumulator too narrow: low notes detuned by more than a cent");
+
+    static constexpr double exactRatio(uint16_t note) {
+        return TableMath::noteFrequency(note) / SAMPLE_RATE < 0.5
+            ? TableMath::noteFrequency(note) / SAMPLE_RATE : 0.5;
+    }
+
+    static constexpr double exact(uint16_t note) {
+        return exactRatio(note) * CYCLE;
+    }
+};
+
+// 2^x over SPAN_CENTS (default one octave) in STEPS steps, ONE * 2^(x/1200)
+// for x = i * SPAN_CENTS / STEPS cents, ONE = 2^FRACTION_BITS, i = 0..STEPS
+// (the last entry is the top of the span, for interpolation)
+template <uint16_t STEPS = 256, uint8_t FRACTION_BITS = 14, typename T = uint16_t,
+          uint16_t SPAN_CENTS = 1200>
+struct Exp2Generator {
+    typedef T Value;
+    static const uint16_t SIZE = STEPS + 1;
+    static constexpr double ONE = TableMath::pow2Int(FRACTION_BITS);
+    static constexpr double SPAN = SPAN_CENTS / 1200.0;
+
+    static_assert(0.5 / ONE < TableMath::CENT, "Too few fraction bits: ratios off by more than a cent");
+    // (2^x)'' = ln2^2 * 2^x, largest at the top of the span
+    static_assert(TableMath::interpolationError(TableMath::exp2(SPAN) * ONE * TableMath::LN2 * TableMath::LN2,
+                                                SPAN / STEPS) < 1,
+                  "Exp2 table too short: interpolation error over 1 LSB");
+
+    static constexpr double exact(uint16_t i) {
+        return ONE * TableMath::exp2(SPAN * i / STEPS);
+    }
+};
+
+// Positive half of tanh, round(A * tanh(RANGE * i/STEPS)) for i = 0..STEPS
+// with A = 2^(BITS-1) - 1. The curve is odd, so negative inputs mirror it.
+template <uint16_t STEPS = 256, uint8_t RANGE = 4, uint8_t BITS = 16, typename T = int16_t>
+struct TanhGenerator {
+    typedef T Value;
+    static const uint16_t SIZE = STEPS + 1;
+    static constexpr double AMPLITUDE = TableMath::pow2Int(BITS - 1) - 1;
+
+    // |tanh''| peaks at 4 / (3 * sqrt(3)) = 0.770
+    static_assert(TableMath::interpolationError(0.770 * AMPLITUDE, (double)RANGE / STEPS) < 1,
+                  "Tanh table too short for its range and bit depth: interpolation error over 1 LSB");
+
+    static constexpr double exact(uint16_t i) {
+        return AMPLITUDE * TableMath::tanh((double)RANGE * i / STEPS);
+    }
+};
+
+// log2(x) over one octave in STEPS steps, ONE * log2(1 + i / STEPS) with
+// ONE = 2^FRACTION_BITS, i = 0..STEPS (the last entry is the top of the
+// octave, for interpolation)
+template <uint16_t STEPS = 256, uint8_t FRACTION_BITS = 15, typename T = uint16_t>
+struct Log2Generator {
+    typedef T Value;
+    static const uint16_t SIZE = STEPS + 1;
+    static constexpr double ONE = TableMath::pow2Int(FRACTION_BITS);
+
+    // log2(x)'' = -1 / (ln2 x^2), largest at the bottom of the octave
+    static_assert(TableMath::interpolationError(ONE / TableMath::LN2, 1.0 / STEPS) < 1,
+                  "Log2 table too short: interpolation error over 1 LSB");
+
+    static constexpr double exact(uint16_t i) {
+        return ONE * TableMath::log2(1 + (double)i / STEPS);
+    }
+};
+
+// Shared tables
+
+// One octave of 2^x in 256 steps, 2.14 fixed point (514 bytes)
+const uint8_t OCTAVE_RATIO_FRACTION_BITS = 14;
+
+typedef GeneratedTable<Exp2Generator<256, OCTAVE_RATIO_FRACTION_BITS, uint16_t> > OctaveRatioTable;
+
+// value * 2^(cents / 1200), clamped to limit. value must be at most 2^31.
+//
+// cents is turned into 1/65536 octaves with one multiply; the whole octaves
+// become a shift and the fraction an interpolated exp2 lookup. Accurate to
+// within a quarter cent over the full int16_t range (+/- 27 octaves).
+// Used for pitch (Oscillator::modulatePitch) and time scaling (envelopes).
+inline uint32_t scaleByCents(uint32_t value, int16_t cents, uint32_t limit = 0xFFFFFFFFUL) {
+    // 65536 / 1200 = 54.6133 = 55924 / 1024
+    int32_t position = ((int32_t)cents * 55924L) >> 10;
+    int16_t octaves = position >> 16;
+    uint8_t index = position >> 8;
+    uint8_t fraction = position;
+
+    uint16_t ratio = pgm_read_word(&OctaveRatioTable::values[index]);
+    if (fraction) {
+        uint16_t next = pgm_read_word(&OctaveRatioTable::values[index + 1]);
+        ratio += ((uint32_t)(next - ratio) * fraction) >> 8;
+    }
+
+    // value * ratio >> 14, split into 16-bit halves of the value
+    uint32_t scaled = (((uint32_t)(uint16_t)(value >> 16) * ratio) << (16 - OCTAVE_RATIO_FRACTION_BITS))
+                    + (((uint32_t)(uint16_t)value * ratio) >> OCTAVE_RATIO_FRACTION_BITS);
+    if (octaves >= 0) {
+        if (octaves >= 32 || scaled > (limit >> octaves)) return limit;
+        return scaled << octaves;
+    }
+    scaled = octaves <= -32 ? 0 : scaled >> -octaves;
+    return scaled > limit ? limit : scaled;
+}
+
+// One octave of log2(x) in 256 steps, 1.15 fixed point (514 bytes)
+const uint8_t OCTAVE_LOG_FRACTION_BITS = 15;
+
+typedef GeneratedTable<Log2Generator<256, OCTAVE_LOG_FRACTION_BITS, uint16_t> > OctaveLogTable;
+
+// log2(value) in 1/65536 octaves, the inverse of scaleByCents(). value must
+// be above 0 (0 gives 0).
+//
+// The top set bit gives the whole octaves and the 16 bits below it an
+// interpolated log2 lookup. Accurate to within 1/15000 octave. Used to
+// time partial envelope segments without a log() (ADSR).
+inline int32_t octavesOf(uint32_t value) {
+    if (value == 0) return 0;
+    int32_t octaves = 31;
+    while (!(value & 0x80000000UL)) {
+        value <<= 1;
+        octaves--;
+    }
+    uint8_t index = value >> 23;
+    uint8_t fraction = value >> 15;
+
+    uint16_t log = pgm_read_word(&OctaveLogTable::values[index]);
+    if (fraction) {
+        uint16_t next = pgm_read_word(&OctaveLogTable::values[index + 1]);
+        log += ((uint32_t)(next - log) * fraction) >> 8;
+    }
+    return (octaves << 16) + ((int32_t)log << (16 - OCTAVE_LOG_FRACTION_BITS));
+}
+
+} // namespace Synth
+
+#endif // TABLE_GEN_H
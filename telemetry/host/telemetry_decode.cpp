@@ -0,0 +1,106 @@
+// Telemetry decoder
+//
+// Reads the binary telemetry stream from a serial port (or a capture file)
+// and prints one CSV line per sample: time_ms,channel,name,value
+// Values are scaled with the exponent from MSG_CHANNEL_INFO when known.
+// History read back from the on-device EEPROM log is printed the same way,
+// named "<channel>/boot<n>" since its times restart with every boot.
+// Text messages and link statistics go to stderr.
+//
+// Build:
+//   g++ -std=c++11 -O2 -o telemetry_decode telemetry_decode.cpp
+//
+// Run:
+//   ./telemetry_decode /dev/ttyACM0 1000000 > samples.csv
+//   ./telemetry_decode capture.bin             (file or - for stdin)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <map>
+#include "telemetry_host.h"
+
+static volatile sig_atomic_t running = 1;
+
+static void stop(int) {
+    running = 0;
+}
+
+static void printSample(const std::map<uint8_t, Telemetry::ChannelInfo>& channels,
+                        uint32_t timeMs, uint8_t channel, const std::string& suffix, int32_t value) {
+    auto it = channels.find(channel);
+    if (it == channels.end()) {
+        printf("%u,%u,%s,%d\n", timeMs, channel, suffix.c_str(), value);
+        return;
+    }
+    int exponent = it->second.exponent;
+    printf("%u,%u,%s%s,%.*f\n", timeMs, channel, it->second.name.c_str(), suffix.c_str(),
+           exponent < 0 ? -exponent : 0, value * pow(10.0, exponent));
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <port|file|-> [baud]\n", argv[0]);
+        return 1;
+    }
+
+    long baud = argc > 2 ? atol(argv[2]) : Telemetry::DEFAULT_BAUD;
+    int fd = strcmp(argv[1], "-") == 0 ? STDIN_FILENO : open(argv[1], O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        fprintf(stderr, "Cannot open %s: %s\n", argv[1], strerror(errno));
+        return 1;
+    }
+    if (!Telemetry::configurePort(fd, baud)) {
+        fprintf(stderr, "Cannot configure %s\n", argv[1]);
+        return 1;
+    }
+
+    signal(SIGINT, stop);
+
+    Telemetry::FrameReader reader;
+    std::map<uint8_t, Telemetry::ChannelInfo> channels;
+    std::vector<Telemetry::Sample> samples;
+    std::vector<Telemetry::LogSample> history;
+    uint8_t buffer[4096];
+
+    printf("time_ms,channel,name,value\n");
+    while (running) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        reader.push(buffer, n);
+
+        Telemetry::Frame frame;
+        while (reader.next(frame)) {
+            Telemetry::ChannelInfo info;
+            uint8_t logId, boot;
+            if (frame.type == Telemetry::MSG_TEXT) {
+                fprintf(stderr, "# %.*s\n", (int)frame.payload.size(), (const char*)frame.payload.data());
+            } else if (Telemetry::parseChannelInfo(frame, info)) {
+                channels[info.channel] = info;
+            } else if (Telemetry::parseSamples(frame, samples)) {
+                for (size_t i = 0; i < samples.size(); i++) {
+                    const Telemetry::Sample& s = samples[i];
+                    printSample(channels, s.timeMs, s.channel, "", s.value);
+                }
+            } else if (Telemetry::parseLogBlock(frame, logId, boot, history)) {
+                std::string suffix = "/boot" + std::to_string(boot);
+                for (size_t i = 0; i < history.size(); i++) {
+                    if (history[i].value == Telemetry::LOG_GAP) continue;
+                    printSample(channels, history[i].timeMs, logId, suffix, history[i].value);
+                }
+            } else if (frame.type == Telemetry::MSG_LOG_BLOCK) {
+                fprintf(stderr, "# corrupt log block\n");
+            }
+        }
+    }
+
+    fprintf(stderr, "# frames %u, corrupt %u, lost %u\n",
+            reader.getFrames(), reader.getCorrupt(), reader.getLost());
+    return 0;
+}
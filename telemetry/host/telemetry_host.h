@@ -0,0 +1,212 @@
+#ifndef TELEMETRY_HOST_H
+#define TELEMETRY_HOST_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <termios.h>
+#include <unistd.h>
+#include <deque>
+#include <string>
+#include <vector>
+#include "../telemetry_codec.h"
+#include "../../eeprom_log/log_block.h"
+
+namespace Telemetry {
+
+// Host side frame reader
+//
+// Feed raw bytes from the serial port with push(). Every time a complete,
+// CRC-checked frame arrives it is returned through next(). Corrupt frames
+// are skipped and counted; gaps in seq are counted as lost frames.
+//
+// Usage:
+//   FrameReader reader;
+//   reader.push(buffer, n);
+//   Frame frame;
+//   while (reader.next(frame)) handle(frame);
+
+struct Frame {
+    uint8_t type;
+    uint8_t seq;
+    std::vector<uint8_t> payload;
+};
+
+struct Sample {
+    uint8_t channel;
+    uint32_t timeMs;
+    int32_t value;
+};
+
+struct ChannelInfo {
+    uint8_t channel;
+    int8_t exponent;
+    std::string name;
+};
+
+class FrameReader {
+public:
+    FrameReader()
+        : _expectedSeq(0)
+        , _synced(false)
+        , _frames(0)
+        , _corrupt(0)
+        , _lost(0)
+    {}
+
+    void push(const uint8_t* data, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            if (data[i] != 0) {
+                // Runaway frame without delimiter, drop it
+                if (_encoded.size() > cobsMaxEncoded(MAX_FRAME)) {
+                    _encoded.clear();
+                    _corrupt++;
+                }
+                _encoded.push_back(data[i]);
+                continue;
+            }
+            if (!_encoded.empty()) decodeFrame();
+            _encoded.clear();
+        }
+    }
+
+    bool next(Frame& frame) {
+        if (_ready.empty()) return false;
+        frame = _ready.front();
+        _ready.pop_front();
+        return true;
+    }
+
+    uint32_t getFrames() const { return _frames; }
+    uint32_t getCorrupt() const { return _corrupt; }
+    uint32_t getLost() const { return _lost; }
+
+private:
+    void decodeFrame() {
+        uint8_t raw[MAX_FRAME + 8];
+        if (_encoded.size() > sizeof(raw)) {
+            _corrupt++;
+            return;
+        }
+
+        size_t len = cobsDecode(_encoded.data(), _encoded.size(), raw);
+        if (len < HEADER_SIZE + CRC_SIZE
+            || crc16(raw, len - CRC_SIZE) != readU16(raw + len - CRC_SIZE)) {
+            _corrupt++;
+            return;
+        }
+
+        Frame frame;
+        frame.type = raw[0];
+        frame.seq = raw[1];
+        frame.payload.assign(raw + HEADER_SIZE, raw + len - CRC_SIZE);
+
+        if (_synced) _lost += (uint8_t)(frame.seq - _expectedSeq);
+        _expectedSeq = frame.seq + 1;
+        _synced = true;
+
+        _frames++;
+        _ready.push_back(frame);
+    }
+
+    std::vector<uint8_t> _encoded;
+    std::deque<Frame> _ready;
+    uint8_t _expectedSeq;
+    bool _synced;
+    uint32_t _frames;
+    uint32_t _corrupt;
+    uint32_t _lost;
+};
+
+// Unpack MSG_SAMPLE and MSG_SAMPLES payloads, false if malformed
+inline bool parseSamples(const Frame& frame, std::vector<Sample>& samples) {
+    samples.clear();
+    const std::vector<uint8_t>& p = frame.payload;
+
+    if (frame.type == MSG_SAMPLE) {
+        if (p.size() != 9) return false;
+        Sample s = { p[0], readU32(&p[1]), readI32(&p[5]) };
+        samples.push_back(s);
+        return true;
+    }
+
+    if (frame.type == MSG_SAMPLES) {
+        if (p.size() < 6 || p.size() != 6 + 4 * (size_t)p[5]) return false;
+        for (uint8_t i = 0; i < p[5]; i++) {
+            Sample s = { (uint8_t)(p[0] + i), readU32(&p[1]), readI32(&p[6 + 4 * i]) };
+            samples.push_back(s);
+        }
+        return true;
+    }
+    return false;
+}
+
+inline bool parseChannelInfo(const Frame& frame, ChannelInfo& info) {
+    if (frame.type != MSG_CHANNEL_INFO || frame.payload.size() < 2) return false;
+    info.channel = frame.payload[0];
+    info.exponent = (int8_t)frame.payload[1];
+    info.name.assign(frame.payload.begin() + 2, frame.payload.end());
+    return true;
+}
+
+struct LogSample {
+    uint32_t timeMs;    // Device millis() during the boot the block was logged in
+    int32_t value;      // LOG_GAP if there was no reading
+};
+
+// Unpack a MSG_LOG_BLOCK payload, false if the block is corrupt
+inline bool parseLogBlock(const Frame& frame, uint8_t& logId, uint8_t& boot,
+                          std::vector<LogSample>& samples) {
+    samples.clear();
+    if (frame.type != MSG_LOG_BLOCK || frame.payload.size() != 1 + LOG_BLOCK_SIZE) return false;
+
+    logId = frame.payload[0];
+    const uint8_t* block = &frame.payload[1];
+    boot = block[LOG_BOOT];
+    return decodeLogBlock(block, [&](uint32_t timeMs, int32_t value) {
+        LogSample s = { timeMs, value };
+        samples.push_back(s);
+    });
+}
+
+// Serial port setup shared by the host tools
+
+inline speed_t toSpeed(long baud) {
+    switch (baud) {
+        case 9600: return B9600;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+#ifdef B500000
+        case 500000: return B500000;
+#endif
+#ifdef B1000000
+        case 1000000: return B1000000;
+#endif
+        default: return 0;
+    }
+}
+
+// Put a tty into raw mode at the given baud, leaves files untouched
+inline bool configurePort(int fd, long baud) {
+    if (!isatty(fd)) return true;
+
+    speed_t speed = toSpeed(baud);
+    if (speed == 0) {
+        fprintf(stderr, "Unsupported baud rate %ld\n", baud);
+        return false;
+    }
+
+    struct termios tty;
+    if (tcgetattr(fd, &tty) != 0) return false;
+    cfmakeraw(&tty);
+    cfsetispeed(&tty, speed);
+    cfsetospeed(&tty, speed);
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cc[VMIN] = 1;
+    tty.c_cc[VTIME] = 0;
+    return tcsetattr(fd, TCSANOW, &tty) == 0;
+}
+
+} // namespace Telemetry
+
+#endif // TELEMETRY_HOST_H
@@ -0,0 +1,374 @@
+// Telemetry ingest and query tool
+//
+// Appends the binary telemetry stream to a compressed columnar store (see
+// telemetry_store.h) and reads it back.
+//
+// Build:
+//   g++ -std=c++11 -O2 -o telemetry_ingest telemetry_ingest.cpp
+//
+// Commands:
+//   telemetry_ingest ingest <store> <port|file|-> [baud]
+//       Record until Ctrl-C or end of input. Device millis() timestamps are
+//       unwrapped and anchored to the host clock (Unix ms) when reading a
+//       serial port; from a file they stay relative to the first sample.
+//   telemetry_ingest info <store>
+//       Channels, sample counts, time span and compression ratio.
+//   telemetry_ingest query <store> <channel> [from_ms to_ms]
+//       CSV of time_ms,value for one channel (name or id).
+//   telemetry_ingest export <store> <channel> <bucket_ms> [from_ms to_ms]
+//       Downsampled CSV of time_ms,min,mean,max,count per bucket.
+//
+// Channels are stored by the names sent in MSG_CHANNEL_INFO ("pt100",
+// "ambient", "object" from the sketches); unnamed channels become "ch<n>".
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <map>
+#include "telemetry_host.h"
+#include "telemetry_store.h"
+
+using namespace Telemetry;
+
+// Flush a channel's open block at least this often so a crash loses little
+static const int64_t MAX_BLOCK_AGE_MS = 60000;
+
+static volatile sig_atomic_t running = 1;
+
+static void stop(int) {
+    running = 0;
+}
+
+static int64_t hostMillis() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+// Maps device millis() to a monotonic 64-bit time, handling the 49 day wrap
+// and device resets.
+// A reset is only assumed after markReset() (the sketches send their
+// MSG_CHANNEL_INFO in setup(), so it marks a boot) or a backwards step of
+// more than RESET_STEP_MS, in case the boot frames were lost. Smaller steps
+// back are glitches: the time holds until the device catches up.
+class DeviceClock {
+public:
+    static const uint32_t RESET_STEP_MS = 10000;
+
+    DeviceClock(bool live)
+        : _live(live), _started(false), _resetPending(false), _last(0), _offset(0), _lastTime(0) {}
+
+    // The device has rebooted, its next timestamp starts a new timeline
+    void markReset() { _resetPending = _started; }
+
+    int64_t toTime(uint32_t device) {
+        if (!_started) {
+            _started = true;
+            _offset = (_live ? hostMillis() : 0) - device;
+        } else if (device < _last) {
+            uint32_t back = _last - device;
+            if (back > 0x80000000u) {
+                _offset += 0x100000000LL;           // millis() wrapped
+            } else if (_resetPending || back > RESET_STEP_MS) {
+                // Device reset: continue from now, never go backwards
+                int64_t now = _live ? hostMillis() : _lastTime + 1;
+                if (now <= _lastTime) now = _lastTime + 1;
+                _offset = now - device;
+            } else {
+                return _lastTime;
+            }
+        }
+        _resetPending = false;
+        _last = device;
+        _lastTime = _offset + device;
+        return _lastTime;
+    }
+
+private:
+    bool _live;
+    bool _started;
+    bool _resetPending;
+    uint32_t _last;
+    int64_t _offset;
+    int64_t _lastTime;
+};
+
+struct OpenBlock {
+    BlockEncoder block;
+    int64_t startedMs;       // Host time the block was started
+};
+
+static int ingest(const char* storePath, const char* input, long baud) {
+    bool stdinInput = strcmp(input, "-") == 0;
+    int fd = stdinInput ? STDIN_FILENO : open(input, O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        fprintf(stderr, "Cannot open %s: %s\n", input, strerror(errno));
+        return 1;
+    }
+    bool live = isatty(fd);
+    if (!configurePort(fd, baud)) {
+        fprintf(stderr, "Cannot configure %s at %ld baud\n", input, baud);
+        return 1;
+    }
+
+    StoreWriter store;
+    if (!store.open(storePath)) {
+        fprintf(stderr, "Cannot open store %s (existing file that is not a store?)\n", storePath);
+        return 1;
+    }
+
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+
+    FrameReader reader;
+    DeviceClock clock(live);
+    std::map<uint8_t, ChannelInfo> deviceChannels;
+    std::map<uint16_t, OpenBlock> blocks;
+    std::vector<Sample> samples;
+    uint8_t buffer[4096];
+    uint64_t stored = 0;
+
+    auto flushBlock = [&](OpenBlock& open) {
+        store.writeBlock(open.block);
+        open.block.reset(open.block.header().channel);
+    };
+
+    while (running) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        reader.push(buffer, n);
+
+        Frame frame;
+        while (reader.next(frame)) {
+            ChannelInfo info;
+            if (parseChannelInfo(frame, info)) {
+                deviceChannels[info.channel] = info;
+                clock.markReset();
+                continue;
+            }
+            if (!parseSamples(frame, samples)) continue;
+
+            int64_t time = clock.toTime(readU32(&frame.payload[1]));
+            for (const Sample& s : samples) {
+                auto known = deviceChannels.find(s.channel);
+                std::string name = known != deviceChannels.end()
+                    ? known->second.name : "ch" + std::to_string(s.channel);
+                int8_t exponent = known != deviceChannels.end() ? known->second.exponent : 0;
+                uint16_t id = store.channelId(name, exponent);
+
+                auto it = blocks.find(id);
+                if (it == blocks.end()) {
+                    it = blocks.insert(std::make_pair(id, OpenBlock())).first;
+                    it->second.block.reset(id);
+                }
+                OpenBlock& open = it->second;
+
+                if (!open.block.append(time, s.value)) {
+                    flushBlock(open);
+                    open.block.append(time, s.value);
+                }
+                if (open.block.getCount() == 1) open.startedMs = hostMillis();
+                stored++;
+            }
+        }
+
+        // Bound how much an unclean exit can lose
+        int64_t now = hostMillis();
+        for (auto& entry : blocks) {
+            OpenBlock& open = entry.second;
+            if (open.block.getCount() > 0 && now - open.startedMs > MAX_BLOCK_AGE_MS) {
+                flushBlock(open);
+            }
+        }
+        store.flush();
+    }
+
+    for (auto& entry : blocks) flushBlock(entry.second);
+    store.close();
+
+    fprintf(stderr, "# stored %llu samples, frames %u, corrupt %u, lost %u\n",
+            (unsigned long long)stored, reader.getFrames(), reader.getCorrupt(), reader.getLost());
+    return 0;
+}
+
+static int info(const char* storePath) {
+    StoreReader reader;
+    if (!reader.open(storePath)) {
+        fprintf(stderr, "Cannot open store %s\n", storePath);
+        return 1;
+    }
+
+    struct Summary { uint64_t samples; uint64_t bytes; uint32_t blocks; int64_t first; int64_t last; };
+    std::map<uint16_t, Summary> summary;
+
+    BlockHeader header;
+    while (reader.nextBlock(header) && reader.skipPayload(header)) {
+        auto it = summary.find(header.channel);
+        if (it == summary.end()) {
+            Summary s = { 0, 0, 0, header.firstTime, header.lastTime };
+            it = summary.insert(std::make_pair(header.channel, s)).first;
+        }
+        Summary& s = it->second;
+        s.samples += header.count;
+        s.bytes += header.payloadBytes + 35;
+        s.blocks++;
+        if (header.firstTime < s.first) s.first = header.firstTime;
+        if (header.lastTime > s.last) s.last = header.lastTime;
+    }
+
+    printf("id,name,exponent,samples,blocks,first_ms,last_ms,bytes_per_sample\n");
+    for (size_t i = 0; i < reader.channels().size(); i++) {
+        const StoreChannel& c = reader.channels()[i];
+        auto it = summary.find(i);
+        if (it == summary.end()) {
+            printf("%zu,%s,%d,0,0,,,\n", i, c.name.c_str(), c.exponent);
+            continue;
+        }
+        const Summary& s = it->second;
+        printf("%zu,%s,%d,%llu,%u,%lld,%lld,%.3f\n", i, c.name.c_str(), c.exponent,
+               (unsigned long long)s.samples, s.blocks, (long long)s.first, (long long)s.last,
+               (double)s.bytes / s.samples);
+    }
+    return 0;
+}
+
+// Calls visit(time, value) for every sample of a channel in [from, to].
+// exponent is set as soon as the channel is known, before the first visit.
+template <typename Visit>
+static int scan(const char* storePath, const char* channelName, int64_t from, int64_t to,
+                int8_t& exponent, Visit visit) {
+    StoreReader reader;
+    if (!reader.open(storePath)) {
+        fprintf(stderr, "Cannot open store %s\n", storePath);
+        return 1;
+    }
+
+    BlockHeader header;
+    std::vector<uint8_t> payload;
+    std::vector<int64_t> times;
+    std::vector<int32_t> values;
+    int channel = -1;
+
+    while (reader.nextBlock(header)) {
+        if (channel < 0) {
+            channel = reader.findChannel(channelName);
+            if (channel >= 0) exponent = reader.channels()[channel].exponent;
+        }
+
+        if ((int)header.channel != channel || header.lastTime < from || header.firstTime > to) {
+            if (!reader.skipPayload(header)) break;
+            continue;
+        }
+        if (!reader.readPayload(header, payload)) break;
+        if (!decodeBlock(header, payload, times, values)) {
+            fprintf(stderr, "# corrupt block at %lld skipped\n", (long long)header.firstTime);
+            continue;
+        }
+        for (size_t i = 0; i < times.size(); i++) {
+            if (times[i] >= from && times[i] <= to) visit(times[i], values[i]);
+        }
+    }
+
+    if (channel < 0 && reader.findChannel(channelName) < 0) {
+        fprintf(stderr, "Unknown channel %s\n", channelName);
+        return 1;
+    }
+    return 0;
+}
+
+static double scaled(double value, int8_t exponent) {
+    return value * pow(10.0, exponent);
+}
+
+static int query(const char* storePath, const char* channel, int64_t from, int64_t to) {
+    int8_t exponent = 0;
+    printf("time_ms,value\n");
+    return scan(storePath, channel, from, to, exponent, [&](int64_t t, int32_t v) {
+        printf("%lld,%.*f\n", (long long)t, exponent < 0 ? -exponent : 0, scaled(v, exponent));
+    });
+}
+
+static int exportBuckets(const char* storePath, const char* channel, int64_t bucketMs,
+                         int64_t from, int64_t to) {
+    struct Bucket { int32_t min; int32_t max; int64_t sum; uint32_t count; };
+    std::map<int64_t, Bucket> buckets;
+    int8_t exponent = 0;
+
+    int result = scan(storePath, channel, from, to, exponent, [&](int64_t t, int32_t v) {
+        int64_t start = t - ((t % bucketMs) + bucketMs) % bucketMs;
+        auto it = buckets.find(start);
+        if (it == buckets.end()) {
+            Bucket b = { v, v, 0, 0 };
+            it = buckets.insert(std::make_pair(start, b)).first;
+        }
+        Bucket& b = it->second;
+        if (v < b.min) b.min = v;
+        if (v > b.max) b.max = v;
+        b.sum += v;
+        b.count++;
+    });
+    if (result != 0) return result;
+
+    int decimals = exponent < 0 ? -exponent : 0;
+    printf("time_ms,min,mean,max,count\n");
+    for (const auto& entry : buckets) {
+        const Bucket& b = entry.second;
+        printf("%lld,%.*f,%.*f,%.*f,%u\n", (long long)entry.first,
+               decimals, scaled(b.min, exponent),
+               decimals + 1, scaled((double)b.sum / b.count, exponent),
+               decimals, scaled(b.max, exponent), b.count);
+    }
+    return 0;
+}
+
+static void usage(const char* name) {
+    fprintf(stderr,
+            "Usage:\n"
+            "  %s ingest <store> <port|file|-> [baud]\n"
+            "  %s info <store>\n"
+            "  %s query <store> <channel> [from_ms to_ms]\n"
+            "  %s export <store> <channel> <bucket_ms> [from_ms to_ms]\n",
+            name, name, name, name);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const char* command = argv[1];
+    const char* store = argv[2];
+
+    if (strcmp(command, "ingest") == 0 && argc >= 4) {
+        return ingest(store, argv[3], argc > 4 ? atol(argv[4]) : DEFAULT_BAUD);
+    }
+    if (strcmp(command, "info") == 0) {
+        return info(store);
+    }
+    if (strcmp(command, "query") == 0 && argc >= 4) {
+        int64_t from = argc > 5 ? atoll(argv[4]) : INT64_MIN;
+        int64_t to = argc > 5 ? atoll(argv[5]) : INT64_MAX;
+        return query(store, argv[3], from, to);
+    }
+    if (strcmp(command, "export") == 0 && argc >= 5) {
+        int64_t bucketMs = atoll(argv[4]);
+        if (bucketMs <= 0) {
+            fprintf(stderr, "bucket_ms must be positive\n");
+            return 1;
+        }
+        int64_t from = argc > 6 ? atoll(argv[5]) : INT64_MIN;
+        int64_t to = argc > 6 ? atoll(argv[6]) : INT64_MAX;
+        return exportBuckets(store, argv[3], bucketMs, from, to);
+    }
+
+    usage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,494 @@
+#ifndef TELEMETRY_STORE_H
+#define TELEMETRY_STORE_H
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+namespace Telemetry {
+
+// Compressed columnar time-series file
+//
+// The store is an append-only sequence of records after an 8 byte header
+// ("TLMS", version, 3 reserved bytes):
+//
+//   'C' channel  id u16, exponent i8, name length u8, name
+//   'B' block    id u16, count u32, firstTime i64, lastTime i64,
+//                minValue i32, maxValue i32, payload length u32, payload
+//
+// Channels are identified by name, so several devices can share one store.
+// Each block holds up to BLOCK_SAMPLES samples of one channel, compressed
+// with the Gorilla scheme:
+// - timestamps (ms) as delta-of-delta in variable-width buckets, so a steady
+//   sample rate costs 1 bit per sample
+// - values (fixed-point int32) XORed with the previous value, storing only
+//   the meaningful bits, so a slowly changing temperature costs a few bits
+//
+// Range queries read only block headers and seek past blocks outside the
+// requested time range or channel.
+
+const uint32_t BLOCK_SAMPLES = 1024;
+
+class BitWriter {
+public:
+    BitWriter() : _bits(0) {}
+
+    // Append the low count bits of value, most significant first
+    void write(uint64_t value, uint8_t count) {
+        while (count > 0) {
+            if (_bits % 8 == 0) _bytes.push_back(0);
+            uint8_t free = 8 - _bits % 8;
+            uint8_t take = count < free ? count : free;
+            uint8_t chunk = (value >> (count - take)) & ((1u << take) - 1);
+            _bytes.back() |= chunk << (free - take);
+            _bits += take;
+            count -= take;
+        }
+    }
+
+    const std::vector<uint8_t>& bytes() const { return _bytes; }
+    void clear() { _bytes.clear(); _bits = 0; }
+
+private:
+    std::vector<uint8_t> _bytes;
+    uint64_t _bits;
+};
+
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t len) : _data(data), _len(len), _bit(0) {}
+
+    // Read count bits, false if the data runs out
+    bool read(uint8_t count, uint64_t& value) {
+        if (_bit + count > (uint64_t)_len * 8) return false;
+        value = 0;
+        while (count > 0) {
+            uint8_t free = 8 - _bit % 8;
+            uint8_t take = count < free ? count : free;
+            uint8_t chunk = (_data[_bit / 8] >> (free - take)) & ((1u << take) - 1);
+            value = (value << take) | chunk;
+            _bit += take;
+            count -= take;
+        }
+        return true;
+    }
+
+private:
+    const uint8_t* _data;
+    size_t _len;
+    uint64_t _bit;
+};
+
+inline uint8_t leadingZeros32(uint32_t x) {
+    uint8_t n = 0;
+    while (n < 32 && !(x & (0x80000000u >> n))) n++;
+    return n;
+}
+
+inline uint8_t trailingZeros32(uint32_t x) {
+    uint8_t n = 0;
+    while (n < 32 && !(x & (1u << n))) n++;
+    return n;
+}
+
+inline uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+inline int64_t unzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+// Delta-of-delta buckets: prefix bits, then a zigzag value of this width.
+// A zero delta-of-delta is the single bit '0'.
+struct DodBucket { uint8_t prefix; uint8_t prefixBits; uint8_t width; };
+const DodBucket DOD_BUCKETS[] = {
+    { 0x2, 2, 7 },     // '10'
+    { 0x6, 3, 9 },     // '110'
+    { 0xE, 4, 12 },    // '1110'
+    { 0xF, 4, 32 }     // '1111'
+};
+
+struct BlockHeader {
+    uint16_t channel;
+    uint32_t count;
+    int64_t firstTime;
+    int64_t lastTime;
+    int32_t minValue;
+    int32_t maxValue;
+    uint32_t payloadBytes;
+};
+
+// Builds one compressed block
+class BlockEncoder {
+public:
+    BlockEncoder() { reset(0); }
+
+    void reset(uint16_t channel) {
+        _header.channel = channel;
+        _header.count = 0;
+        _header.payloadBytes = 0;
+        _bits.clear();
+        _lastDelta = 0;
+        _lastValue = 0;
+        _windowValid = false;
+        _leading = 0;
+        _trailing = 0;
+    }
+
+    // Add a sample, false if it cannot go in this block (full, or the
+    // timestamp jump does not fit) and a new block must be started
+    bool append(int64_t timeMs, int32_t value) {
+        if (_header.count >= BLOCK_SAMPLES) return false;
+
+        if (_header.count == 0) {
+            _header.firstTime = timeMs;
+            _header.minValue = value;
+            _header.maxValue = value;
+            _bits.write((uint32_t)value, 32);
+        } else {
+            int64_t delta = timeMs - _header.lastTime;
+            int64_t dod = delta - _lastDelta;
+            if (dod < INT32_MIN / 2 || dod > INT32_MAX / 2) return false;
+            writeTime(dod);
+            writeValue(value);
+            _lastDelta = delta;
+        }
+
+        _header.lastTime = timeMs;
+        _lastValue = value;
+        if (value < _header.minValue) _header.minValue = value;
+        if (value > _header.maxValue) _header.maxValue = value;
+        _header.count++;
+        return true;
+    }
+
+    uint32_t getCount() const { return _header.count; }
+    int64_t getFirstTime() const { return _header.firstTime; }
+
+    const BlockHeader& header() {
+        _header.payloadBytes = _bits.bytes().size();
+        return _header;
+    }
+
+    const std::vector<uint8_t>& payload() const { return _bits.bytes(); }
+
+private:
+    void writeTime(int64_t dod) {
+        if (dod == 0) {
+            _bits.write(0, 1);
+            return;
+        }
+        uint64_t z = zigzag(dod);
+        for (const DodBucket& b : DOD_BUCKETS) {
+            if (z < (1ull << b.width)) {
+                _bits.write(b.prefix, b.prefixBits);
+                _bits.write(z, b.width);
+                return;
+            }
+        }
+    }
+
+    void writeValue(int32_t value) {
+        uint32_t x = (uint32_t)value ^ (uint32_t)_lastValue;
+        if (x == 0) {
+            _bits.write(0, 1);
+            return;
+        }
+
+        uint8_t leading = leadingZeros32(x);
+        uint8_t trailing = trailingZeros32(x);
+
+        if (_windowValid && leading >= _leading && trailing >= _trailing) {
+            // Fits the previous meaningful-bit window
+            _bits.write(0x2, 2);
+            _bits.write(x >> _trailing, 32 - _leading - _trailing);
+            return;
+        }
+
+        uint8_t length = 32 - leading - trailing;
+        _bits.write(0x3, 2);
+        _bits.write(leading, 5);
+        _bits.write(length - 1, 5);
+        _bits.write(x >> trailing, length);
+        _windowValid = true;
+        _leading = leading;
+        _trailing = trailing;
+    }
+
+    BlockHeader _header;
+    BitWriter _bits;
+    int64_t _lastDelta;
+    int32_t _lastValue;
+    bool _windowValid;
+    uint8_t _leading;
+    uint8_t _trailing;
+};
+
+// Decompress a block payload, false if it is corrupt
+inline bool decodeBlock(const BlockHeader& header, const std::vector<uint8_t>& payload,
+                        std::vector<int64_t>& times, std::vector<int32_t>& values) {
+    times.clear();
+    values.clear();
+    if (header.count == 0) return true;
+
+    BitReader bits(payload.data(), payload.size());
+    uint64_t v;
+    if (!bits.read(32, v)) return false;
+
+    int64_t time = header.firstTime;
+    int64_t delta = 0;
+    uint32_t value = (uint32_t)v;
+    uint8_t leading = 0;
+    uint8_t trailing = 0;
+    times.push_back(time);
+    values.push_back((int32_t)value);
+
+    for (uint32_t i = 1; i < header.count; i++) {
+        // Timestamp
+        uint64_t bit;
+        int64_t dod = 0;
+        if (!bits.read(1, bit)) return false;
+        if (bit) {
+            // '1' has been read: count further 1s to pick the bucket
+            uint8_t bucket = 0;
+            while (bucket < 3) {
+                if (!bits.read(1, bit)) return false;
+                if (!bit) break;
+                bucket++;
+            }
+            uint64_t z;
+            if (!bits.read(DOD_BUCKETS[bucket].width, z)) return false;
+            dod = unzigzag(z);
+        }
+        delta += dod;
+        time += delta;
+
+        // Value
+        if (!bits.read(1, bit)) return false;
+        if (bit) {
+            uint64_t control;
+            if (!bits.read(1, control)) return false;
+            if (control) {
+                uint64_t lz, len;
+                if (!bits.read(5, lz) || !bits.read(5, len)) return false;
+                leading = lz;
+                trailing = 32 - leading - (len + 1);
+                if (leading + len + 1 > 32) return false;
+            }
+            uint64_t meaningful;
+            if (!bits.read(32 - leading - trailing, meaningful)) return false;
+            value ^= (uint32_t)(meaningful << trailing);
+        }
+
+        times.push_back(time);
+        values.push_back((int32_t)value);
+    }
+    return true;
+}
+
+struct StoreChannel {
+    std::string name;
+    int8_t exponent;
+};
+
+const uint8_t STORE_VERSION = 1;
+
+// Sequential reader over the records of a store
+class StoreReader {
+public:
+    StoreReader() : _file(nullptr) {}
+    ~StoreReader() { if (_file) fclose(_file); }
+
+    bool open(const char* path) {
+        _file = fopen(path, "rb");
+        if (_file == nullptr) return false;
+
+        uint8_t header[8];
+        if (fread(header, 1, sizeof(header), _file) != sizeof(header)
+            || header[0] != 'T' || header[1] != 'L' || header[2] != 'M' || header[3] != 'S'
+            || header[4] != STORE_VERSION) {
+            fclose(_file);
+            _file = nullptr;
+            return false;
+        }
+        _validEnd = sizeof(header);
+        return true;
+    }
+
+    // Next block header, registering channel records on the way.
+    // Returns false at the end of the file (or at a truncated record).
+    bool nextBlock(BlockHeader& header) {
+        for (;;) {
+            int type = fgetc(_file);
+            uint64_t v[7];
+
+            if (type == 'C') {
+                if (!getLE(v[0], 2) || !getLE(v[1], 1) || !getLE(v[2], 1)) return false;
+                std::string name(v[2], '\0');
+                if (fread(&name[0], 1, v[2], _file) != v[2]) return false;
+                StoreChannel channel = { name, (int8_t)v[1] };
+                _channels.push_back(channel);
+                _validEnd = ftell(_file);
+                continue;
+            }
+
+            if (type != 'B') return false;
+            if (!getLE(v[0], 2) || !getLE(v[1], 4) || !getLE(v[2], 8) || !getLE(v[3], 8)
+                || !getLE(v[4], 4) || !getLE(v[5], 4) || !getLE(v[6], 4)) return false;
+            header.channel = v[0];
+            header.count = v[1];
+            header.firstTime = (int64_t)v[2];
+            header.lastTime = (int64_t)v[3];
+            header.minValue = (int32_t)v[4];
+            header.maxValue = (int32_t)v[5];
+            header.payloadBytes = v[6];
+            return header.channel < _channels.size();
+        }
+    }
+
+    // Read or skip the payload of the block just returned by nextBlock()
+    bool readPayload(const BlockHeader& header, std::vector<uint8_t>& payload) {
+        payload.resize(header.payloadBytes);
+        if (fread(payload.data(), 1, header.payloadBytes, _file) != header.payloadBytes) return false;
+        _validEnd = ftell(_file);
+        return true;
+    }
+
+    bool skipPayload(const BlockHeader& header) {
+        long start = ftell(_file);
+        fseek(_file, 0, SEEK_END);
+        if (ftell(_file) - start < (long)header.payloadBytes) return false;
+        fseek(_file, start + header.payloadBytes, SEEK_SET);
+        _validEnd = start + header.payloadBytes;
+        return true;
+    }
+
+    // Offset just after the last complete record
+    long validEnd() const { return _validEnd; }
+
+    const std::vector<StoreChannel>& channels() const { return _channels; }
+
+    // Channel by name or by numeric id, -1 if unknown
+    int findChannel(const std::string& nameOrId) const {
+        for (size_t i = 0; i < _channels.size(); i++) {
+            if (_channels[i].name == nameOrId) return i;
+        }
+        char* end;
+        long id = strtol(nameOrId.c_str(), &end, 10);
+        if (*end == '\0' && id >= 0 && id < (long)_channels.size()) return id;
+        return -1;
+    }
+
+private:
+    bool getLE(uint64_t& value, uint8_t bytes) {
+        value = 0;
+        for (uint8_t i = 0; i < bytes; i++) {
+            int c = fgetc(_file);
+            if (c == EOF) return false;
+            value |= (uint64_t)c << (8 * i);
+        }
+        return true;
+    }
+
+    FILE* _file;
+    long _validEnd;
+    std::vector<StoreChannel> _channels;
+};
+
+// Appends records to a store file
+class StoreWriter {
+public:
+    StoreWriter() : _file(nullptr) {}
+    ~StoreWriter() { close(); }
+
+    // Open or create a store. An incomplete record left by a crash is cut off.
+    // A new store is only created in place of a missing or empty file, any
+    // other file that is not a store is refused and left untouched.
+    bool open(const char* path) {
+        close();
+        StoreReader reader;
+        long end = 0;
+        if (reader.open(path)) {
+            BlockHeader header;
+            while (reader.nextBlock(header) && reader.skipPayload(header)) {}
+            _channels = reader.channels();
+            end = reader.validEnd();
+        } else if (!missingOrEmpty(path)) {
+            return false;
+        }
+
+        _file = fopen(path, end > 0 ? "r+b" : "w+b");
+        if (_file == nullptr) return false;
+
+        if (end == 0) {
+            const uint8_t header[8] = { 'T', 'L', 'M', 'S', STORE_VERSION, 0, 0, 0 };
+            fwrite(header, 1, sizeof(header), _file);
+        } else {
+            if (ftruncate(fileno(_file), end) != 0) return false;
+            fseek(_file, end, SEEK_SET);
+        }
+        return true;
+    }
+
+    void close() {
+        if (_file) fclose(_file);
+        _file = nullptr;
+    }
+
+    // Id for a channel name, adding a channel record if it is new
+    uint16_t channelId(const std::string& name, int8_t exponent) {
+        for (size_t i = 0; i < _channels.size(); i++) {
+            if (_channels[i].name == name) return i;
+        }
+
+        StoreChannel channel = { name.substr(0, 255), exponent };
+        _channels.push_back(channel);
+        uint16_t id = _channels.size() - 1;
+
+        putU8('C');
+        putLE(id, 2);
+        putU8((uint8_t)exponent);
+        putU8(channel.name.size());
+        fwrite(channel.name.data(), 1, channel.name.size(), _file);
+        return id;
+    }
+
+    bool writeBlock(BlockEncoder& block) {
+        if (block.getCount() == 0) return true;
+        const BlockHeader& h = block.header();
+        putU8('B');
+        putLE(h.channel, 2);
+        putLE(h.count, 4);
+        putLE(h.firstTime, 8);
+        putLE(h.lastTime, 8);
+        putLE((uint32_t)h.minValue, 4);
+        putLE((uint32_t)h.maxValue, 4);
+        putLE(h.payloadBytes, 4);
+        return fwrite(block.payload().data(), 1, h.payloadBytes, _file) == h.payloadBytes;
+    }
+
+    void flush() { if (_file) fflush(_file); }
+
+    const std::vector<StoreChannel>& channels() const { return _channels; }
+
+private:
+    static bool missingOrEmpty(const char* path) {
+        struct stat st;
+        if (stat(path, &st) != 0) return errno == ENOENT;
+        return st.st_size == 0;
+    }
+
+    void putU8(uint8_t value) { fputc(value, _file); }
+
+    void putLE(uint64_t value, uint8_t bytes) {
+        for (uint8_t i = 0; i < bytes; i++) putU8(value >> (8 * i));
+    }
+
+    FILE* _file;
+    std::vector<StoreChannel> _channels;
+};
+
+} // namespace Telemetry
+
+#endif // TELEMETRY_STORE_H
@@ -0,0 +1,207 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include "telemetry_codec.h"
+
+namespace Telemetry {
+
+// Binary telemetry link
+//
+// Frames (see telemetry_codec.h) are built in a small linear buffer, then
+// COBS encoded straight into a TX ring. service() moves bytes from the ring
+// to the port only as far as port.availableForWrite() allows, so no call
+// ever waits for the UART. When the ring is full a frame is dropped whole
+// and counted in getDropped(); the host also sees the gap in seq.
+//
+// A sample frame is 15 bytes on the wire against ~60 bytes of text, and the
+// link runs at up to 1 Mbaud instead of 9600.
+//
+// Frames must be sent from the main loop only, not from interrupts.
+//
+// Usage:
+//   Telemetry::Link<256> link(Serial);
+//   Serial.begin(Telemetry::DEFAULT_BAUD);
+//   link.sendChannelInfo(0, -2, "hotend");      // centi-degrees C
+//   loop() {
+//       link.sendSample(0, millis(), temperatureCentiC);
+//       link.service();
+//   }
+//
+// Decode on the host with telemetry/host/telemetry_decode.cpp.
+
+template <uint16_t SIZE = 256>
+class Link {
+    static_assert((SIZE & (SIZE - 1)) == 0, "SIZE must be a power of two");
+    static_assert(SIZE >= 2 * MAX_FRAME, "SIZE too small for a frame");
+
+public:
+    Link(Print& port)
+        : _port(port)
+        , _head(0)
+        , _tail(0)
+        , _length(0)
+        , _seq(0)
+        , _overflow(false)
+        , _dropped(0)
+    {}
+
+    // Start a frame of the given type, then add the payload with put*()
+    void begin(uint8_t type) {
+        _frame[0] = type;
+        _frame[1] = _seq;
+        _length = HEADER_SIZE;
+        _overflow = false;
+    }
+
+    void putU8(uint8_t value) {
+        if (_length >= HEADER_SIZE + MAX_PAYLOAD) {
+            _overflow = true;
+            return;
+        }
+        _frame[_length++] = value;
+    }
+
+    void putU16(uint16_t value) {
+        putU8(value);
+        putU8(value >> 8);
+    }
+
+    void putU32(uint32_t value) {
+        putU16(value);
+        putU16(value >> 16);
+    }
+
+    void putI32(int32_t value) { putU32((uint32_t)value); }
+
+    void putBytes(const uint8_t* data, uint8_t len) {
+        for (uint8_t i = 0; i < len; i++) putU8(data[i]);
+    }
+
+    // Finish the frame and queue it, false if it was dropped
+    bool end() {
+        if (_overflow) {
+            _dropped++;
+            return false;
+        }
+
+        uint16_t crc = crc16(_frame, _length);
+        _frame[_length++] = crc;
+        _frame[_length++] = crc >> 8;
+
+        if (free() < cobsMaxEncoded(_length)) {
+            _dropped++;
+            return false;
+        }
+
+        encodeToRing(_frame, _length);
+        _seq++;
+        return true;
+    }
+
+    bool sendSample(uint8_t channel, uint32_t timeMs, int32_t value) {
+        begin(MSG_SAMPLE);
+        putU8(channel);
+        putU32(timeMs);
+        putI32(value);
+        return end();
+    }
+
+    // Several channels sampled at the same time, firstChannel upwards
+    bool sendSamples(uint8_t firstChannel, uint32_t timeMs, const int32_t* values, uint8_t count) {
+        begin(MSG_SAMPLES);
+        putU8(firstChannel);
+        putU32(timeMs);
+        putU8(count);
+        for (uint8_t i = 0; i < count; i++) putI32(values[i]);
+        return end();
+    }
+
+    // Name a channel and give its scale: value = raw * 10^exponent
+    bool sendChannelInfo(uint8_t channel, int8_t exponent, const char* name) {
+        begin(MSG_CHANNEL_INFO);
+        putU8(channel);
+        putU8((uint8_t)exponent);
+        putBytes((const uint8_t*)name, strlen(name));
+        return end();
+    }
+
+    bool sendText(const char* text) {
+        begin(MSG_TEXT);
+        putBytes((const uint8_t*)text, strlen(text));
+        return end();
+    }
+
+    // Push queued bytes to the port without blocking. Call every loop.
+    void service() {
+        int room = _port.availableForWrite();
+        while (room > 0 && _head != _tail) {
+            // Largest contiguous run in the ring
+            uint16_t run = (_head > _tail ? _head : SIZE) - _tail;
+            if (run > (uint16_t)room) run = room;
+
+            _port.write(&_ring[_tail], run);
+            _tail = (_tail + run) & (SIZE - 1);
+            room -= run;
+        }
+    }
+
+    // True if a frame with this much payload would be queued right now
+    bool canSend(uint8_t payloadLength) const {
+        return free() >= cobsMaxEncoded(HEADER_SIZE + payloadLength + CRC_SIZE);
+    }
+
+    // Bytes waiting in the ring
+    uint16_t pending() const { return (_head - _tail) & (SIZE - 1); }
+
+    uint16_t getDropped() const { return _dropped; }
+
+private:
+    // One slot is kept empty to tell full from empty
+    uint16_t free() const { return SIZE - 1 - pending(); }
+
+    void push(uint8_t value) {
+        _ring[_head] = value;
+        _head = (_head + 1) & (SIZE - 1);
+    }
+
+    // COBS encode into the ring, patching each code byte once its block ends
+    void encodeToRing(const uint8_t* data, uint8_t len) {
+        uint16_t codeIndex = _head;
+        push(0);
+        uint8_t code = 1;
+
+        for (uint8_t i = 0; i < len; i++) {
+            if (data[i] == 0) {
+                _ring[codeIndex] = code;
+                codeIndex = _head;
+                push(0);
+                code = 1;
+            } else {
+                push(data[i]);
+                if (++code == 0xFF) {
+                    _ring[codeIndex] = code;
+                    codeIndex = _head;
+                    push(0);
+                    code = 1;
+                }
+            }
+        }
+        _ring[codeIndex] = code;
+        push(0);   // Frame delimiter
+    }
+
+    Print& _port;
+    uint8_t _ring[SIZE];
+    uint16_t _head;
+    uint16_t _tail;
+    uint8_t _frame[MAX_FRAME];
+    uint8_t _length;
+    uint8_t _seq;
+    bool _overflow;
+    uint16_t _dropped;
+};
+
+} // namespace Telemetry
+
+#endif // TELEMETRY_H
@@ -0,0 +1,130 @@
+#ifndef TELEMETRY_CODEC_H
+#define TELEMETRY_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Telemetry wire format, shared by the sketches and the host tools.
+// Plain C++11 with no Arduino dependencies so host code can include it.
+//
+// Frame, before encoding:
+//   [type u8][seq u8][payload ...][crc16 u16]
+// - seq increments per frame so the host can count lost frames
+// - crc16 is CRC-16/CCITT-FALSE over type, seq and payload
+// - all multi-byte fields are little-endian
+//
+// On the wire each frame is COBS encoded (no zero bytes inside) and
+// terminated by a single 0x00, so a receiver can resynchronise at the next
+// zero after any corruption.
+//
+// Payloads (values are fixed-point integers, see MSG_CHANNEL_INFO):
+//   MSG_TEXT          char[]                     free text, not terminated
+//   MSG_CHANNEL_INFO  ch u8, exp i8, char[] name value = raw * 10^exp
+//   MSG_SAMPLE        ch u8, time u32, value i32
+//   MSG_SAMPLES       ch u8, time u32, n u8, value i32[n]
+//                                                channels ch .. ch+n-1 at one time
+//   MSG_LOG_BLOCK     log u8, block[64]          stored history, see log_block.h
+
+namespace Telemetry {
+
+enum MessageType : uint8_t {
+    MSG_TEXT = 0x01,
+    MSG_CHANNEL_INFO = 0x02,
+    MSG_SAMPLE = 0x10,
+    MSG_SAMPLES = 0x11,
+    MSG_LOG_BLOCK = 0x20
+};
+
+// Largest unencoded payload a frame may carry
+const uint8_t MAX_PAYLOAD = 72;
+const uint8_t HEADER_SIZE = 2;
+const uint8_t CRC_SIZE = 2;
+const uint8_t MAX_FRAME = HEADER_SIZE + MAX_PAYLOAD + CRC_SIZE;
+
+// Worst case COBS output for len input bytes, including the 0x00 delimiter
+inline size_t cobsMaxEncoded(size_t len) {
+    return len + len / 254 + 2;
+}
+
+// Baud rates with 0% error on a 16 MHz AVR (U2X enabled)
+const uint32_t BAUD_250K = 250000;
+const uint32_t BAUD_500K = 500000;
+const uint32_t BAUD_1M = 1000000;
+const uint32_t DEFAULT_BAUD = BAUD_1M;
+
+inline uint16_t crc16Update(uint16_t crc, uint8_t data) {
+    crc ^= (uint16_t)data << 8;
+    for (uint8_t i = 0; i < 8; i++) {
+        crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+inline uint16_t crc16(const uint8_t* data, size_t len, uint16_t crc = 0xFFFF) {
+    for (size_t i = 0; i < len; i++) {
+        crc = crc16Update(crc, data[i]);
+    }
+    return crc;
+}
+
+// COBS encode len bytes into out (at least cobsMaxEncoded(len) - 1 bytes).
+// Returns the encoded length, the 0x00 delimiter is not written.
+inline size_t cobsEncode(const uint8_t* in, size_t len, uint8_t* out) {
+    size_t codeIndex = 0;
+    size_t o = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[codeIndex] = code;
+            codeIndex = o++;
+            code = 1;
+        } else {
+            out[o++] = in[i];
+            if (++code == 0xFF) {
+                out[codeIndex] = code;
+                codeIndex = o++;
+                code = 1;
+            }
+        }
+    }
+    out[codeIndex] = code;
+    return o;
+}
+
+// COBS decode len bytes (without the delimiter) into out (at least len bytes).
+// Returns the decoded length, or 0 if the input is malformed.
+inline size_t cobsDecode(const uint8_t* in, size_t len, uint8_t* out) {
+    size_t i = 0;
+    size_t o = 0;
+
+    while (i < len) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > len) return 0;
+
+        for (uint8_t j = 1; j < code; j++) {
+            out[o++] = in[i++];
+        }
+        if (code != 0xFF && i < len) {
+            out[o++] = 0;
+        }
+    }
+    return o;
+}
+
+inline uint16_t readU16(const uint8_t* p) {
+    return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+inline uint32_t readU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8)
+         | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+inline int32_t readI32(const uint8_t* p) {
+    return (int32_t)readU32(p);
+}
+
+} // namespace Telemetry
+
+#endif // TELEMETRY_CODEC_H
@@ -0,0 +1,109 @@
+#ifndef MLX_CAPTURE_SOURCE_H
+#define MLX_CAPTURE_SOURCE_H
+
+#include <Arduino.h>
+
+#define TIMER_USES_CAPTURE
+#include "timer_alloc.h"
+#include "temperature_source.h"
+
+namespace Thermal {
+
+// Kept apart from temperature_source.h so only sketches that use it reserve
+// TIMER_CAPTURE (see timer_alloc.h).
+
+// MLX90614 PWM output timed by the input capture unit of TIMER_CAPTURE
+// instead of an external interrupt. The edges are timestamped in hardware
+// (0.5 us at 16 MHz), so the reading does not jitter with interrupt
+// latency, and it leaves the INTn pins free: on the Mega pin 2 (INT4) is
+// also OC3B, the second audio output of PWMAudio::beginDual().
+//
+// The sensor must be wired to TIMER_CAPTURE_PIN(TIMER_CAPTURE) (Mega:
+// pin 48, ICP5). One instance per sketch, and the sketch defines the ISR:
+//   Thermal::MLXCaptureSource irSensor;
+//   ISR(TIMER_CAPTURE_CAPT_vect) { irSensor.handleCapture(); }
+class MLXCaptureSource : public TemperatureSource {
+public:
+    static const uint8_t PIN = TIMER_CAPTURE_PIN(TIMER_CAPTURE);
+
+    MLXCaptureSource(int16_t rangeMin = -10, int16_t rangeMax = 160, uint16_t timeoutMs = 50)
+        : _rangeMin(rangeMin)
+        , _rangeMax(rangeMax)
+        , _timeoutMs(timeoutMs)
+        , _riseTicks(0)
+        , _highTicks(0)
+        , _fresh(false)
+        , _lastEdgeMs(0)
+    {}
+
+    void begin() override {
+        pinMode(PIN, INPUT);
+
+        uint8_t oldSREG = SREG;
+        cli();
+
+        // Normal mode, prescaler 8, noise canceller on, capture rising edges
+        TIMER_REG(TCCR, TIMER_CAPTURE, A) = 0;
+        TIMER_REG(TCCR, TIMER_CAPTURE, B) = (1 << ICNC1) | (1 << ICES1) | (1 << CS11);
+        TIMER_REG(TCNT, TIMER_CAPTURE, ) = 0;
+        TIMER_REG(TIFR, TIMER_CAPTURE, ) = (1 << ICF1);
+        TIMER_REG(TIMSK, TIMER_CAPTURE, ) = (1 << ICIE1);
+
+        SREG = oldSREG;
+    }
+
+    bool poll(uint32_t nowMs) override {
+        uint16_t highTicks;
+        bool fresh;
+
+        uint8_t oldSREG = SREG;
+        cli();
+        highTicks = _highTicks;
+        fresh = _fresh;
+        _fresh = false;
+        SREG = oldSREG;
+
+        if (fresh) {
+            _lastEdgeMs = nowMs;
+            uint32_t highUs = (uint32_t)highTicks * 8 / (F_CPU / 1000000UL);
+            return publish(nowMs, mlxPwmToCentiC(highUs, _rangeMin, _rangeMax), true);
+        }
+
+        // Sensor silent (unplugged or switched to SMBus)
+        if (_latest.valid && nowMs - _lastEdgeMs > _timeoutMs) {
+            return publish(nowMs, 0, false);
+        }
+        return false;
+    }
+
+    // Called from the capture interrupt - do not call directly
+    void handleCapture() {
+        uint16_t ticks = TIMER_REG(ICR, TIMER_CAPTURE, );
+        uint8_t control = TIMER_REG(TCCR, TIMER_CAPTURE, B);
+
+        if (control & (1 << ICES1)) {
+            _riseTicks = ticks;
+            TIMER_REG(TCCR, TIMER_CAPTURE, B) = control & ~(1 << ICES1);
+        } else {
+            // 16-bit wrap-around is fine, a sensor period is ~1 ms
+            _highTicks = ticks - _riseTicks;
+            _fresh = true;
+            TIMER_REG(TCCR, TIMER_CAPTURE, B) = control | (1 << ICES1);
+        }
+        // Switching the edge can raise a false capture
+        TIMER_REG(TIFR, TIMER_CAPTURE, ) = (1 << ICF1);
+    }
+
+private:
+    int16_t _rangeMin;
+    int16_t _rangeMax;
+    uint16_t _timeoutMs;
+    uint16_t _riseTicks;
+    volatile uint16_t _highTicks;
+    volatile bool _fresh;
+    uint32_t _lastEdgeMs;
+};
+
+} // namespace Thermal
+
+#endif // MLX_CAPTURE_SOURCE_H
@@ -0,0 +1,46 @@
+#ifndef MLX_I2C_SOURCE_H
+#define MLX_I2C_SOURCE_H
+
+#include <Arduino.h>
+#include <Adafruit_MLX90614.h>
+#include "temperature_source.h"
+
+namespace Thermal {
+
+// Kept apart from temperature_source.h so sketches without the MLX90614
+// library (e.g. the PT100 amplifier) can still use the other sources.
+
+// MLX90614 object (or ambient) temperature over SMBus.
+// Each poll() that is due does a single 3-byte register read (~0.5 ms at
+// 100 kHz); the sensor updates its RAM about every 100 ms anyway.
+class MLXI2CSource : public TemperatureSource {
+public:
+    MLXI2CSource(Adafruit_MLX90614& mlx, uint16_t periodMs = 100, bool ambient = false)
+        : _mlx(mlx)
+        , _periodMs(periodMs)
+        , _ambient(ambient)
+        , _primed(false)
+        , _lastMs(0)
+    {}
+
+    bool poll(uint32_t nowMs) override {
+        if (_primed && nowMs - _lastMs < _periodMs) return false;
+        _primed = true;
+        _lastMs = nowMs;
+
+        double temperature = _ambient ? _mlx.readAmbientTempC() : _mlx.readObjectTempC();
+        if (isnan(temperature)) return publish(nowMs, 0, false);
+        return publish(nowMs, (int32_t)(temperature * 100), true);
+    }
+
+private:
+    Adafruit_MLX90614& _mlx;
+    uint16_t _periodMs;
+    bool _ambient;
+    bool _primed;
+    uint32_t _lastMs;
+};
+
+} // namespace Thermal
+
+#endif // MLX_I2C_SOURCE_H
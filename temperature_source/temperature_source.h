@@ -0,0 +1,248 @@
+#ifndef TEMPERATURE_SOURCE_H
+#define TEMPERATURE_SOURCE_H
+
+#include <Arduino.h>
+#include "pt100.h"
+
+namespace Thermal {
+
+// Non-blocking temperature sources
+//
+// Every sensor is wrapped in a TemperatureSource with the same contract:
+//   poll(now)  - do a bounded amount of work, never wait on the sensor.
+//                Returns true when a new reading was published.
+//   latest()   - last reading: centi-degrees C, millis() timestamp and a
+//                validity flag.
+//
+// A loop can poll any mix of sources back to back and hand latest() to
+// controllers, loggers or telemetry without knowing which sensor it is.
+//
+// Implementations:
+//   MLXI2CSource  - MLX90614 over SMBus, one short transaction per period
+//                   (mlx_i2c_source.h, needs the Adafruit MLX90614 library)
+//   MLXPWMSource  - MLX90614 PWM output timed by an external interrupt
+//   MLXCaptureSource - the same timed by TIMER_CAPTURE's input capture
+//                   (mlx_capture_source.h)
+//   PT100Source   - E3D PT100 amplifier on the ADC, conversions started and
+//                   collected without busy-waiting
+//
+// Usage:
+//   PT100Source pt100(A13);
+//   MLXPWMSource ir(18);
+//   TemperatureSource* sources[] = { &pt100, &ir };
+//   pt100.begin(); ir.begin();
+//   loop() {
+//       for (auto* s : sources) s->poll(millis());
+//       if (pt100.latest().valid) use(pt100.latest().centiC);
+//   }
+
+struct TemperatureReading {
+    int32_t centiC;      // 2150 = 21.50 C
+    uint32_t timeMs;     // millis() when the reading was taken
+    bool valid;
+};
+
+class TemperatureSource {
+public:
+    TemperatureSource() {
+        _latest.centiC = 0;
+        _latest.timeMs = 0;
+        _latest.valid = false;
+    }
+
+    virtual void begin() {}
+
+    // Advance the acquisition, returns true if a new reading was published
+    virtual bool poll(uint32_t nowMs) = 0;
+
+    const TemperatureReading& latest() const { return _latest; }
+
+    // True if the last reading is valid and no older than maxAgeMs
+    bool isFresh(uint32_t nowMs, uint32_t maxAgeMs) const {
+        return _latest.valid && nowMs - _latest.timeMs <= maxAgeMs;
+    }
+
+protected:
+    bool publish(uint32_t nowMs, int32_t centiC, bool valid) {
+        _latest.timeMs = nowMs;
+        _latest.valid = valid;
+        if (valid) _latest.centiC = centiC;
+        return true;
+    }
+
+    TemperatureReading _latest;
+};
+
+// Convert an MLX90614 single-PWM high time to centi-degrees C
+// T = 2 * (high / 2048) * (Tmax - Tmin) + Tmin
+inline int32_t mlxPwmToCentiC(unsigned long highDuration, int16_t rangeMin, int16_t rangeMax) {
+    return (int32_t)rangeMin * 100
+         + ((int32_t)highDuration * (rangeMax - rangeMin) * 100) / 1024;
+}
+
+// MLX90614 PWM output measured by edge interrupts instead of pulseIn().
+// The pin must be an external interrupt pin (Mega: 2, 3, 18, 19, 20, 21).
+// rangeMin/rangeMax must match the TOMIN/TOMAX the sensor was set up with.
+class MLXPWMSource : public TemperatureSource {
+public:
+    static const uint8_t MAX_INSTANCES = 6;
+
+    MLXPWMSource(uint8_t pin, int16_t rangeMin = -10, int16_t rangeMax = 160,
+                 uint16_t timeoutMs = 50)
+        : _pin(pin)
+        , _rangeMin(rangeMin)
+        , _rangeMax(rangeMax)
+        , _timeoutMs(timeoutMs)
+        , _riseUs(0)
+        , _highUs(0)
+        , _fresh(false)
+        , _lastEdgeMs(0)
+    {}
+
+    void begin() override {
+        pinMode(_pin, INPUT);
+        uint8_t irq = digitalPinToInterrupt(_pin);
+        if (irq >= MAX_INSTANCES) return;
+        instances()[irq] = this;
+        attachInterrupt(irq, trampoline(irq), CHANGE);
+    }
+
+    bool poll(uint32_t nowMs) override {
+        uint32_t highUs;
+        bool fresh;
+
+        uint8_t oldSREG = SREG;
+        cli();
+        highUs = _highUs;
+        fresh = _fresh;
+        _fresh = false;
+        SREG = oldSREG;
+
+        if (fresh) {
+            _lastEdgeMs = nowMs;
+            return publish(nowMs, mlxPwmToCentiC(highUs, _rangeMin, _rangeMax), true);
+        }
+
+        // Sensor silent (unplugged or switched to SMBus)
+        if (_latest.valid && nowMs - _lastEdgeMs > _timeoutMs) {
+            return publish(nowMs, 0, false);
+        }
+        return false;
+    }
+
+    // Called from the edge interrupt - do not call directly
+    void handleEdge() {
+        uint32_t now = micros();
+        if (digitalRead(_pin)) {
+            _riseUs = now;
+        } else if (_riseUs != 0) {
+            _highUs = now - _riseUs;
+            _fresh = true;
+        }
+    }
+
+private:
+    typedef void (*Trampoline)();
+
+    static MLXPWMSource** instances() {
+        static MLXPWMSource* table[MAX_INSTANCES] = {};
+        return table;
+    }
+
+    template <uint8_t IRQ>
+    static void dispatch() {
+        MLXPWMSource* source = instances()[IRQ];
+        if (source) source->handleEdge();
+    }
+
+    static Trampoline trampoline(uint8_t irq) {
+        static const Trampoline table[MAX_INSTANCES] = {
+            dispatch<0>, dispatch<1>, dispatch<2>, dispatch<3>, dispatch<4>, dispatch<5>
+        };
+        return table[irq];
+    }
+
+    uint8_t _pin;
+    int16_t _rangeMin;
+    int16_t _rangeMax;
+    uint16_t _timeoutMs;
+    volatile uint32_t _riseUs;
+    volatile uint32_t _highUs;
+    volatile bool _fresh;
+    uint32_t _lastEdgeMs;
+};
+
+// E3D PT100 amplifier read through the ADC without blocking.
+// poll() starts a conversion and collects it on a later call (a conversion
+// takes ~110 us at the default prescaler). Sources share the ADC: only one
+// conversion is in flight at a time, others wait for their turn. Do not mix
+// with analogRead() while a conversion may be pending.
+class PT100Source : public TemperatureSource {
+public:
+    PT100Source(uint8_t pin, uint16_t periodMs = 100, uint16_t vrefMv = 5000)
+        : _pin(pin)
+        , _periodMs(periodMs)
+        , _vrefMv(vrefMv)
+        , _converting(false)
+        , _primed(false)
+        , _lastMs(0)
+    {}
+
+    void begin() override {
+        // ADC enabled, prescaler 128 (125 kHz at 16 MHz), as analogRead() does
+        ADCSRA = (1 << ADEN) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);
+    }
+
+    bool poll(uint32_t nowMs) override {
+        if (_converting) {
+            if (ADCSRA & (1 << ADSC)) return false;   // Still converting
+
+            uint16_t raw = ADC;
+            _converting = false;
+            owner() = nullptr;
+
+            int32_t centiC;
+            bool valid = pt100AdcToCentiC(raw, _vrefMv, centiC);
+            return publish(nowMs, centiC, valid);
+        }
+
+        if (_primed && nowMs - _lastMs < _periodMs) return false;
+        if (owner() != nullptr) return false;          // ADC busy, try next poll
+
+        _primed = true;
+        _lastMs = nowMs;
+        startConversion();
+        return false;
+    }
+
+private:
+    static PT100Source*& owner() {
+        static PT100Source* current = nullptr;
+        return current;
+    }
+
+    void startConversion() {
+        uint8_t channel = _pin >= A0 ? _pin - A0 : _pin;
+        owner() = this;
+        _converting = true;
+
+#if defined(MUX5)
+        // Channels 8-15 (A8-A15 on the Mega) are selected with MUX5
+        ADCSRB = (ADCSRB & ~(1 << MUX5)) | (((channel >> 3) & 0x01) << MUX5);
+#endif
+        // AVcc reference, right-adjusted result
+        ADMUX = (1 << REFS0) | (channel & 0x07);
+        ADCSRA |= (1 << ADSC);
+    }
+
+    uint8_t _pin;
+    uint16_t _periodMs;
+    uint16_t _vrefMv;
+    bool _converting;
+    bool _primed;
+    uint32_t _lastMs;
+};
+
+} // namespace Thermal
+
+#endif // TEMPERATURE_SOURCE_H
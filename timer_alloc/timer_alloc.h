@@ -0,0 +1,152 @@
+#ifndef TIMER_ALLOC_H
+#define TIMER_ALLOC_H
+
+#include <Arduino.h>
+
+// Hardware timer allocation
+//
+// Every module that drives a hardware timer takes its timer number from one
+// of these roles instead of hard-coding TCCRx writes:
+//   TIMER_AUDIO_SAMPLE  sample-rate interrupt (PWMAudioISR)       16-bit
+//   TIMER_AUDIO_PWM     audio PWM output (PWMAudio, PWMAudioISR)  8 or 16-bit
+//   TIMER_HEATER        time-proportioning window (HeaterOutputISR) 16-bit
+//   TIMER_CAPTURE       input capture (MLXCaptureSource)          16-bit, with an ICPn pin
+//
+// Defaults on the Mega keep every role on its own timer, leaving Timer0 to
+// millis() and Timer2 to tone():
+//   audio sample Timer1, audio PWM Timer3 (pins 5/2), heater Timer4,
+//   capture Timer5 (ICP5 = pin 48)
+// Override any role with a build flag, e.g. -DTIMER_AUDIO_PWM=2.
+//
+// Conflicts are compile errors. A module announces the roles it uses by
+// defining TIMER_USES_<ROLE> before including this file, and the checks at
+// the end run on every include, so two modules in one sketch cannot end up
+// on the same timer. On the Uno (Timer1 is the only 16-bit timer) this
+// means audio and heater output cannot be combined, which is reported
+// instead of silently breaking.
+//
+// Helpers build register, pin and vector names from a timer number:
+//   TIMER_REG(TCCR, TIMER_HEATER, B)   -> TCCR4B
+//   TIMER_PIN(TIMER_AUDIO_PWM, A)      -> 5 (OC3A)
+//   TIMER_CAPTURE_PIN(TIMER_CAPTURE)   -> 48 (ICP5)
+//   ISR(TIMER_HEATER_COMPA_vect)       -> ISR(TIMER4_COMPA_vect)
+// The 16-bit timers share one bit layout, so modules use the Timer1 bit
+// names (WGM12, CS10, OCIE1A, ...) for all of them.
+
+#if defined(__AVR_ATmega2560__) || defined(__AVR_ATmega1280__)
+
+#ifndef TIMER_AUDIO_SAMPLE
+#define TIMER_AUDIO_SAMPLE 1
+#endif
+#ifndef TIMER_AUDIO_PWM
+#define TIMER_AUDIO_PWM 3
+#endif
+#ifndef TIMER_HEATER
+#define TIMER_HEATER 4
+#endif
+#ifndef TIMER_CAPTURE
+#define TIMER_CAPTURE 5
+#endif
+
+// Output compare pins
+#define TIMER_PIN_1A 11
+#define TIMER_PIN_1B 12
+#define TIMER_PIN_2A 10
+#define TIMER_PIN_2B 9
+#define TIMER_PIN_3A 5
+#define TIMER_PIN_3B 2
+#define TIMER_PIN_4A 6
+#define TIMER_PIN_4B 7
+#define TIMER_PIN_5A 46
+#define TIMER_PIN_5B 45
+
+// Input capture pins, 0 where the pin is not broken out
+#define TIMER_CAPTURE_PIN_1 0
+#define TIMER_CAPTURE_PIN_3 0
+#define TIMER_CAPTURE_PIN_4 49
+#define TIMER_CAPTURE_PIN_5 48
+
+#define TIMER_IS_16BIT(n) ((n) == 1 || (n) == 3 || (n) == 4 || (n) == 5)
+
+#elif defined(__AVR_ATmega328P__)
+
+#ifndef TIMER_AUDIO_SAMPLE
+#define TIMER_AUDIO_SAMPLE 1
+#endif
+#ifndef TIMER_AUDIO_PWM
+#define TIMER_AUDIO_PWM 2
+#endif
+#ifndef TIMER_HEATER
+#define TIMER_HEATER 1
+#endif
+#ifndef TIMER_CAPTURE
+#define TIMER_CAPTURE 1
+#endif
+
+#define TIMER_PIN_1A 9
+#define TIMER_PIN_1B 10
+#define TIMER_PIN_2A 11
+#define TIMER_PIN_2B 3
+
+#define TIMER_CAPTURE_PIN_1 8
+
+#define TIMER_IS_16BIT(n) ((n) == 1)
+
+#else
+#error "timer_alloc.h: no timer table for this MCU"
+#endif
+
+#define TIMER_PASTE(a, b, c) a##b##c
+#define TIMER_REG(prefix, n, suffix) TIMER_PASTE(prefix, n, suffix)
+#define TIMER_PIN(n, channel) TIMER_PASTE(TIMER_PIN_, n, channel)
+#define TIMER_CAPTURE_PIN(n) TIMER_PASTE(TIMER_CAPTURE_PIN_, n, )
+#define TIMER_VECT(n, name) TIMER_PASTE(TIMER, n, _##name##_vect)
+
+#define TIMER_AUDIO_SAMPLE_COMPA_vect TIMER_VECT(TIMER_AUDIO_SAMPLE, COMPA)
+#define TIMER_HEATER_COMPA_vect TIMER_VECT(TIMER_HEATER, COMPA)
+#define TIMER_CAPTURE_CAPT_vect TIMER_VECT(TIMER_CAPTURE, CAPT)
+
+#endif // TIMER_ALLOC_H
+
+// Allocation checks, evaluated again on every include
+
+#if defined(TIMER_USES_AUDIO_SAMPLE) && !TIMER_IS_16BIT(TIMER_AUDIO_SAMPLE)
+#error "TIMER_AUDIO_SAMPLE must be a 16-bit timer"
+#endif
+#if defined(TIMER_USES_HEATER) && !TIMER_IS_16BIT(TIMER_HEATER)
+#error "TIMER_HEATER must be a 16-bit timer"
+#endif
+#if defined(TIMER_USES_CAPTURE) && !TIMER_IS_16BIT(TIMER_CAPTURE)
+#error "TIMER_CAPTURE must be a 16-bit timer"
+#endif
+#if defined(TIMER_USES_CAPTURE) && TIMER_IS_16BIT(TIMER_CAPTURE) && TIMER_CAPTURE_PIN(TIMER_CAPTURE) == 0
+#error "TIMER_CAPTURE has no input capture pin on this board"
+#endif
+#if defined(TIMER_USES_AUDIO_PWM) && (TIMER_AUDIO_PWM == 0)
+#error "TIMER_AUDIO_PWM cannot be Timer0, it runs millis()"
+#endif
+
+#if defined(TIMER_USES_AUDIO_SAMPLE) && defined(TIMER_USES_AUDIO_PWM) \
+    && TIMER_AUDIO_SAMPLE == TIMER_AUDIO_PWM
+#error "Timer conflict: audio sample interrupt and audio PWM"
+#endif
+#if defined(TIMER_USES_AUDIO_SAMPLE) && defined(TIMER_USES_HEATER) \
+    && TIMER_AUDIO_SAMPLE == TIMER_HEATER
+#error "Timer conflict: audio sample interrupt and heater output"
+#endif
+#if defined(TIMER_USES_AUDIO_SAMPLE) && defined(TIMER_USES_CAPTURE) \
+    && TIMER_AUDIO_SAMPLE == TIMER_CAPTURE
+#error "Timer conflict: audio sample interrupt and input capture"
+#endif
+#if defined(TIMER_USES_AUDIO_PWM) && defined(TIMER_USES_HEATER) \
+    && TIMER_AUDIO_PWM == TIMER_HEATER
+#error "Timer conflict: audio PWM and heater output"
+#endif
+#if defined(TIMER_USES_AUDIO_PWM) && defined(TIMER_USES_CAPTURE) \
+    && TIMER_AUDIO_PWM == TIMER_CAPTURE
+#error "Timer conflict: audio PWM and input capture"
+#endif
+#if defined(TIMER_USES_HEATER) && defined(TIMER_USES_CAPTURE) \
+    && TIMER_HEATER == TIMER_CAPTURE
+#error "Timer conflict: heater output and input capture"
+#endif
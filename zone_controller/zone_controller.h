@@ -0,0 +1,154 @@
+#ifndef ZONE_CONTROLLER_H
+#define ZONE_CONTROLLER_H
+
+#include <Arduino.h>
+#include "pid.h"
+#include "heater_output.h"
+#include "temperature_source.h"
+
+namespace Thermal {
+
+// Multi-zone thermal controller
+//
+// Each zone binds a TemperatureSource to a heater channel and a PID.
+// Every call to service() polls all sources (non-blocking), then, if its
+// slot is due, runs the PID of one zone on that zone's latest reading. The
+// control period is divided into one slot per zone, so the work per call is
+// bounded and every zone keeps the same control period whatever mix of
+// sensors it uses.
+//
+// A zone whose reading is invalid or older than one control period is
+// treated as faulted and its heater is switched off.
+//
+// Heater switching runs from HeaterOutputISR, so it is unaffected by how
+// long the reads take.
+//
+// Usage:
+//   ZoneController<4> zones(500);                  // 500 ms per zone
+//   MLXI2CSource ir(mlx);                          // mlx_i2c_source.h
+//   PT100Source pt100(A13);
+//   zones.addZone(&ir, 36, "Hotend");
+//   zones.addZone(&pt100, 38, "Block");
+//   zones.zone(0).pid.setTunings(0.1f, 0.002f, 0.5f);
+//   zones.setSetpoint(0, 4000);
+//   zones.begin();
+//   loop() { zones.service(millis()); }
+
+struct Zone {
+    const char* name;       // For reports, set by addZone()
+    TemperatureSource* source;
+    PID pid;
+    uint8_t heaterChannel;
+    bool enabled;
+    bool valid;             // Source reading valid and fresh
+    int32_t temperature;    // Last good reading, centi-degrees C
+    uint16_t duty;
+    uint16_t faults;        // Consecutive failed readings
+};
+
+template <uint8_t N>
+class ZoneController {
+public:
+    ZoneController(uint16_t periodMs = 500)
+        : _periodMs(periodMs)
+        , _count(0)
+        , _current(0)
+        , _nextSlotMs(0)
+    {}
+
+    // Add a zone, returns its index or -1 if the table or heater channels are full
+    int8_t addZone(TemperatureSource* source, uint8_t heaterPin, const char* name = "") {
+        if (_count >= N) return -1;
+
+        uint8_t ch = HeaterOutputISR::instance().attach(heaterPin);
+        if (ch == HeaterOutputISR::INVALID_CHANNEL) return -1;
+
+        Zone& z = _zones[_count];
+        z.name = name;
+        z.source = source;
+        z.pid.setPeriod(_periodMs);
+        z.heaterChannel = ch;
+        z.enabled = true;
+        z.valid = false;
+        z.temperature = 0;
+        z.duty = 0;
+        z.faults = 0;
+        return _count++;
+    }
+
+    void begin() {
+        for (uint8_t i = 0; i < _count; i++) {
+            _zones[i].source->begin();
+        }
+        _current = 0;
+        _nextSlotMs = millis();
+    }
+
+    void setSetpoint(uint8_t index, int32_t centiC) {
+        if (index < _count) _zones[index].pid.setSetpoint(centiC);
+    }
+
+    void setEnabled(uint8_t index, bool enabled) {
+        if (index >= _count) return;
+        _zones[index].enabled = enabled;
+        if (!enabled) setDuty(_zones[index], 0);
+    }
+
+    // Service the next zone if its slot is due. Returns true if a zone ran.
+    bool service(uint32_t nowMs) {
+        for (uint8_t i = 0; i < _count; i++) {
+            _zones[i].source->poll(nowMs);
+        }
+
+        if (_count == 0 || (int32_t)(nowMs - _nextSlotMs) < 0) return false;
+
+        serviceZone(_zones[_current], nowMs);
+        _current = (_current + 1) % _count;
+
+        uint16_t slotMs = _periodMs / _count;
+        _nextSlotMs += slotMs;
+        // If we fell more than a full period behind, drop the backlog
+        if ((int32_t)(nowMs - _nextSlotMs) > (int32_t)_periodMs) {
+            _nextSlotMs = nowMs + slotMs;
+        }
+        return true;
+    }
+
+    Zone& zone(uint8_t index) { return _zones[index]; }
+    const Zone& zone(uint8_t index) const { return _zones[index]; }
+    uint8_t getCount() const { return _count; }
+    uint16_t getPeriod() const { return _periodMs; }
+
+private:
+    void serviceZone(Zone& z, uint32_t nowMs) {
+        z.valid = z.source->isFresh(nowMs, _periodMs);
+
+        if (!z.valid) {
+            // Fail safe: no reading, no heat
+            if (z.faults < 0xFFFF) z.faults++;
+            setDuty(z, 0);
+            return;
+        }
+
+        z.faults = 0;
+        z.temperature = z.source->latest().centiC;
+        if (z.enabled) {
+            setDuty(z, z.pid.update(z.temperature));
+        }
+    }
+
+    void setDuty(Zone& z, uint16_t duty) {
+        z.duty = duty;
+        HeaterOutputISR::instance().setDuty(z.heaterChannel, duty);
+    }
+
+    Zone _zones[N];
+    uint16_t _periodMs;
+    uint8_t _count;
+    uint8_t _current;
+    uint32_t _nextSlotMs;
+};
+
+} // namespace Thermal
+
+#endif // ZONE_CONTROLLER_H